@@ -7,12 +7,26 @@
 #include <errno.h>
 #include <getopt.h>
 #include <limits.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sysexits.h>
 
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+
 
 static void print_usage() {
 	const char *implied = strcmp(program_invocation_short_name, "bech32m") == 0 ? "Bech32m" : NULL;
@@ -23,12 +37,65 @@ static void print_usage() {
 		else if (strcmp(program_invocation_short_name, "blech32m") == 0)
 			implied = "Blech32m";
 #endif
-	fprintf(stderr, "usage: %1$s [-h]%2$s <hrp> { [<version>] | -d [-v|<version>] }\n\n"
+	fprintf(stderr, "usage: %1$s [-h]%2$s <hrp> { [<version>] | -d [--auto] [-v|<version>] }\n"
+		"       %1$s --binary%2$s <hrp> { [<version>] | -d [--auto] [-v|<version>] }\n"
+		"       %1$s --build-set=<file> [--eytzinger]\n"
+		"       %1$s --query-set=<file>\n"
+		"       %1$s --scan <file>...\n"
+		"       %1$s --generate=<count>"
+#ifndef DISABLE_BLECH32
+			" [-l]"
+#endif
+			" [--seed=<n>] [--versions=<list>]\n"
+		"                [--invalid=<percent>] [--faults=<list>] [--binary] [<hrp>...]\n"
+		"       %1$s --serve=<socket>\n"
+		"       %1$s --connect=<socket> [-h]%2$s <hrp> { [<version>] | -d [--auto] [-v|<version>] }\n\n"
 		"Reads data from stdin and writes its %3$s encoding to stdout. If <version>\n"
 		"is given, its least significant 5 bits are encoded as a SegWit version field.\n\n"
+		"--build-set=<file>\n"
+		"    Read SegWit addresses from stdin, one per line, and write them to <file>\n"
+		"    as a compact binary address set.\n"
+#ifndef DISABLE_BLECH32
+		"    With -l, read blinding addresses.\n"
+#endif
+		"--eytzinger\n"
+		"    Lay out the records of the address set in Eytzinger order.\n"
+		"--query-set=<file>\n"
+		"    Read addresses from stdin, one per line, and write those that are in the\n"
+		"    address set <file> to stdout.\n"
+		"--scan <file>...\n"
+		"    Write every valid encoding found in the given files to stdout, preceded\n"
+		"    by its byte offset and, if more than one file is given, the file name.\n"
+		"--generate=<count>\n"
+		"    Write <count> pseudorandom SegWit addresses to stdout, one per line, with\n"
+		"    prefixes chosen from the given <hrp>s.\n"
+#ifndef DISABLE_BLECH32
+		"    With -l, write blinding addresses.\n"
+#endif
+		"--seed=<n>\n"
+		"    Seed the generator with <n> instead of 0.\n"
+		"--versions=<list>\n"
+		"    Choose witness versions from the comma-separated <list> instead of 0,1.\n"
+		"--invalid=<percent>\n"
+		"    Make <percent> of the generated addresses invalid.\n"
+		"--faults=<list>\n"
+		"    Make addresses invalid only in the listed ways: checksum, case, char.\n"
+		"--binary\n"
+		"    Precede each generated address by its size as a 2-byte big-endian\n"
+		"    integer instead of following it by a newline. Without --generate,\n"
+		"    encode or decode each of a stream of records so framed on stdin, and\n"
+		"    write the results to stdout in the same framing. With -d and -v, begin\n"
+		"    each decoded record with the version field extracted from it.\n"
+		"--serve=<socket>\n"
+		"    Listen on the Unix-domain <socket> and serve framed encode/decode/verify\n"
+		"    requests until terminated.\n"
+		"--connect=<socket>\n"
+		"    Have the server listening on <socket> perform the encoding or decoding.\n"
 		"-d,--decode\n"
 		"    Decode a %3$s encoding from stdin and write the data to stdout. If\n"
 		"    <version> is given, assert that it matches the version field in the data.\n"
+		"--auto\n"
+		"    With -d, accept any variant, determining which from the checksum.\n"
 		"-h,--hex\n"
 		"    Use hexadecimal for data input/output.\n"
 		"%4$s"
@@ -61,35 +128,72 @@ static void print_usage() {
 	);
 }
 
-static int gethex() {
-	static const int8_t DECODE['f' + 1 - '0'] = {
-		 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
-		-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-		-1, 10, 11, 12, 13, 14, 15
-	};
-	int hi, lo;
-	if ((hi = getchar()) < 0)
-		return hi;
-	if ((hi -= '0') >= 0 && hi <= 'f' - '0' && (hi = DECODE[hi]) >= 0) {
-		if ((lo = getchar()) >= 0 && (lo -= '0') >= 0 && lo <= 'f' - '0' && (lo = DECODE[lo]) >= 0)
-			return hi << 4 | lo;
+enum {
+	HEX_BLOCK_SIZE = 8, // bytes converted per vector
+};
+
+// Decodes n_out bytes from 2 * n_out hexadecimal digits of either case, a block at a time. Returns false if any character is
+// not a hexadecimal digit.
+static bool decode_hex(unsigned char out[], const char in[], size_t n_out) {
+	size_t i = 0;
+#ifdef __SSE2__
+	for (; n_out - i >= HEX_BLOCK_SIZE; i += HEX_BLOCK_SIZE) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (in + 2 * i));
+		// unsigned minimum finds the bytes that fall within each range once it is shifted to start at zero
+		__m128i digit = _mm_sub_epi8(x, _mm_set1_epi8('0')), alpha = _mm_sub_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+		__m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+		__m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8('f' - 'a')), alpha);
+		if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) != 0xFFFF)
+			return false;
+		__m128i v = _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+		// each 16-bit lane holds a high nibble in its low byte and a low nibble in its high byte
+		v = _mm_and_si128(_mm_or_si128(_mm_slli_epi16(v, 4), _mm_srli_epi16(v, 8)), _mm_set1_epi16(0xFF));
+		_mm_storel_epi64((__m128i *) (out + i), _mm_packus_epi16(v, v));
+	}
+#endif
+	for (; i < n_out; ++i) {
+		unsigned v[2];
+		for (size_t j = 0; j < 2; ++j) {
+			unsigned c = (unsigned char) in[2 * i + j];
+			if ((v[j] = c - '0' <= 9 ? c - '0' : (c | 0x20) - 'a' <= 'f' - 'a' ? (c | 0x20) - 'a' + 10 : 16) > 15)
+				return false;
+		}
+		out[i] = (unsigned char) (v[0] << 4 | v[1]);
 	}
-	else if (hi == '\n' - '0')
-		return EOF;
-	errx(EX_DATAERR, "invalid hex on stdin");
+	return true;
 }
 
-static ssize_t fwrite_hex(const unsigned char in[], size_t n_in, FILE *out) {
+// Encodes n_in bytes as 2 * n_in lowercase hexadecimal digits, a block at a time, and returns the number of digits.
+static size_t format_hex(char out[], const unsigned char in[], size_t n_in) {
 	static const char ENCODE[16] = {
 		'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
 	};
-	for (size_t i = 0; i < n_in; ++i) {
-		char x[2] = { ENCODE[in[i] >> 4], ENCODE[in[i] & 0xF] };
-		if (fwrite(x, 1, 2, out) < 2)
-			return -1;
+	size_t i = 0;
+#ifdef __SSE2__
+	for (; n_in - i >= HEX_BLOCK_SIZE; i += HEX_BLOCK_SIZE) {
+		__m128i x = _mm_loadl_epi64((const __m128i *) (in + i)), mask = _mm_set1_epi8(0xF);
+		__m128i v = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(x, 4), mask), _mm_and_si128(x, mask));
+		v = _mm_add_epi8(_mm_add_epi8(v, _mm_set1_epi8('0')), _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10)));
+		_mm_storeu_si128((__m128i *) (out + 2 * i), v);
+	}
+#endif
+	for (; i < n_in; ++i)
+		out[2 * i] = ENCODE[in[i] >> 4], out[2 * i + 1] = ENCODE[in[i] & 0xF];
+	return 2 * n_in;
+}
+
+// Reads a line from stdin into buf and returns its length without its newline, which is n - 1 if the line is longer than
+// n - 2 characters. Unlike a bare fgets, admits null characters, leaving them in the line for the caller to reject.
+static size_t read_line(char buf[], size_t n) {
+	// the null character that fgets appends to what it reads is then the last in the buffer
+	memset(buf, 0xFF, n);
+	if (!fgets(buf, (int) n, stdin)) {
+		if (ferror(stdin))
+			err(EX_IOERR, "error reading from stdin");
+		return 0;
 	}
-	return putc('\n', out) < 0 ? -1 : (ssize_t) n_in;
+	size_t n_line = (size_t) ((const char *) memrchr(buf, '\0', n) - buf);
+	return n_line && buf[n_line - 1] == '\n' ? n_line - 1 : n_line;
 }
 
 static const char *errmsg(enum bech32_error error) {
@@ -114,16 +218,770 @@ static const char *errmsg(enum bech32_error error) {
 			return "human-readable prefix is too long";
 		case BECH32_HRP_ILLEGAL_CHAR:
 			return "invalid human-readable prefix";
-		case BECH32_BUFFER_INADEQUATE:
 		case SEGWIT_VERSION_ILLEGAL:
+			return "witness version is illegal";
 		case SEGWIT_PROGRAM_TOO_SHORT:
+			return "witness program is too short";
 		case SEGWIT_PROGRAM_TOO_LONG:
+			return "witness program is too long";
 		case SEGWIT_PROGRAM_ILLEGAL_SIZE:
+			return "witness program is of illegal size";
+		case BECH32_BUFFER_INADEQUATE:
 			break;
 	}
 	__builtin_unreachable();
 }
 
+// The parameters and results of a single encoding or decoding, as performed for the command line or for a client of the
+// server.
+struct codec {
+	const char *hrp;
+	size_t n_hrp;
+	int8_t version; // the version field to encode or to assert, or -1; after decoding, the version field decoded, if any
+	bool decode, modified, extract_version;
+#ifndef DISABLE_BLECH32
+	bool blech;
+#endif
+	bool detect; // decode whichever variant the checksum indicates; after decoding, the variant is in modified and blech
+	char msg[128]; // after a failure, the error message
+};
+
+static int __attribute__ ((__format__ (__printf__, 3, 4))) codec_error(struct codec *codec, int status, const char *format, ...) {
+	va_list args;
+	va_start(args, format);
+	vsnprintf(codec->msg, sizeof codec->msg, format, args);
+	va_end(args);
+	return status;
+}
+
+static int codec_check_hrp(struct codec *codec) {
+	size_t nmin_hrp, nmax_hrp;
+#ifndef DISABLE_BLECH32
+	if (codec->blech || codec->detect)
+		nmin_hrp = BLECH32_HRP_MIN_SIZE, nmax_hrp = BLECH32_HRP_MAX_SIZE;
+	else
+#endif
+		nmin_hrp = BECH32_HRP_MIN_SIZE, nmax_hrp = BECH32_HRP_MAX_SIZE;
+	if (codec->n_hrp < nmin_hrp)
+		return codec_error(codec, EX_USAGE, "%s", errmsg(BECH32_HRP_TOO_SHORT));
+	if (codec->n_hrp > nmax_hrp)
+		return codec_error(codec, EX_USAGE, "%s", errmsg(BECH32_HRP_TOO_LONG));
+	return EX_OK;
+}
+
+// Returns the maximum size of the input: the encoding to decode or the data to encode.
+static size_t __attribute__ ((__pure__)) codec_max_in(const struct codec *codec) {
+#ifndef DISABLE_BLECH32
+	if (codec->blech || codec->detect)
+		return codec->decode ? BLECH32_MAX_SIZE :
+				(BLECH32_MAX_SIZE - codec->n_hrp - 1/*separator*/ - (codec->version >= 0) - BLECH32_CHECKSUM_SIZE) * 5 / CHAR_BIT;
+#endif
+	return codec->decode ? BECH32_MAX_SIZE :
+			(BECH32_MAX_SIZE - codec->n_hrp - 1/*separator*/ - (codec->version >= 0) - BECH32_CHECKSUM_SIZE) * 5 / CHAR_BIT;
+}
+
+// Returns the maximum size of the output: the decoded data or the encoding.
+static size_t __attribute__ ((__pure__)) codec_max_out(const struct codec *codec) {
+#ifndef DISABLE_BLECH32
+	return codec->blech || codec->detect ? BLECH32_MAX_SIZE : BECH32_MAX_SIZE;
+#else
+	(void) codec;
+	return BECH32_MAX_SIZE;
+#endif
+}
+
+// Decodes hexadecimal input to encode into out, which must have room for one byte more than codec_max_in, so that input too
+// long to encode is distinguished from input that is merely malformed. Returns EX_OK or, after setting the error message,
+// the exit status for the failure.
+static int codec_parse_hex(struct codec *codec, unsigned char out[], const char in[], size_t n_in, size_t *n_out) {
+	size_t nmax_in = codec_max_in(codec);
+	*n_out = n_in / 2 <= nmax_in ? n_in / 2 : nmax_in + 1;
+	if (!decode_hex(out, in, *n_out) || *n_out <= nmax_in && n_in % 2)
+		return codec_error(codec, EX_DATAERR, "invalid hex on stdin");
+	if (*n_out > nmax_in)
+		return codec_error(codec, EX_DATAERR, "%s", errmsg(BECH32_TOO_LONG));
+	return EX_OK;
+}
+
+// Encodes or decodes the input. Returns EX_OK or, after setting the error message, the exit status for the failure.
+static int codec_run(struct codec *codec, const unsigned char in[], size_t n_in, unsigned char out[], size_t *n_out) {
+	if (n_in > codec_max_in(codec))
+		return codec_error(codec, EX_DATAERR, "%s", errmsg(BECH32_TOO_LONG));
+	const char *const hrp = codec->hrp;
+	const size_t n_hrp = codec->n_hrp;
+	unsigned char version = (unsigned char) codec->version;
+	if (codec->decode) {
+		if (codec->detect) {
+			// one pass over the encoding finds the variant, which is then decoded as though it had been specified
+			ssize_t variant = bech32_detect((const char *) in, n_in);
+			if (variant < 0)
+				return codec_error(codec, EX_DATAERR, "%s", errmsg((enum bech32_error) variant));
+#ifndef DISABLE_BLECH32
+			codec->blech = variant == BECH32_VARIANT_BLECH32 || variant == BECH32_VARIANT_BLECH32M;
+			codec->modified = variant == BECH32_VARIANT_BECH32M || variant == BECH32_VARIANT_BLECH32M;
+#else
+			codec->modified = variant == BECH32_VARIANT_BECH32M;
+#endif
+		}
+#ifndef DISABLE_BLECH32
+		if (codec->blech) {
+			if (n_in < BLECH32_MIN_SIZE)
+				return codec_error(codec, EX_DATAERR, "%s", errmsg(BECH32_TOO_SHORT));
+			ssize_t ret;
+			struct blech32_decoder_state state;
+			if ((ret = blech32_decode_begin(&state, (const char *) in, n_in)) < 0)
+				return codec_error(codec, EX_DATAERR, "%s", errmsg((enum bech32_error) ret));
+			if ((size_t) ret != n_hrp || strncasecmp((const char *) in, hrp, ret))
+				return codec_error(codec, EX_DATAERR, "human-readable prefix was \"%.*s\", not \"%.*s\"", (int) ret, in, (int) n_hrp, hrp);
+			if (codec->version >= 0 || codec->extract_version) {
+				if (blech32_decode_bits_remaining(&state) < 5)
+					return codec_error(codec, EX_DATAERR, "%s", errmsg(BECH32_TOO_SHORT));
+				if ((ret = blech32_decode_data(&state, &version, 5)) < 0)
+					return codec_error(codec, EX_DATAERR, "%s", errmsg((enum bech32_error) ret));
+				if (codec->version >= 0 && version != codec->version)
+					return codec_error(codec, EX_DATAERR, "version was %d, not %d", version, codec->version);
+				codec->version = (int8_t) version;
+			}
+			*n_out = blech32_decode_bits_remaining(&state) / CHAR_BIT;
+			assert(*n_out <= codec_max_out(codec));
+			if ((ret = blech32_decode_data(&state, out, *n_out * CHAR_BIT)) < 0 ||
+					(ret = blech32_decode_finish(&state, codec->modified ? BLECH32M_CONST : 1)) < 0)
+				return codec_error(codec, EX_DATAERR, "%s", errmsg((enum bech32_error) ret));
+		}
+		else
+#endif
+		{
+			if (n_in < BECH32_MIN_SIZE)
+				return codec_error(codec, EX_DATAERR, "%s", errmsg(BECH32_TOO_SHORT));
+			ssize_t ret;
+			struct bech32_decoder_state state;
+			if ((ret = bech32_decode_begin(&state, (const char *) in, n_in)) < 0)
+				return codec_error(codec, EX_DATAERR, "%s", errmsg((enum bech32_error) ret));
+			if ((size_t) ret != n_hrp || strncasecmp((const char *) in, hrp, ret))
+				return codec_error(codec, EX_DATAERR, "human-readable prefix was \"%.*s\", not \"%.*s\"", (int) ret, in, (int) n_hrp, hrp);
+			if (codec->version >= 0 || codec->extract_version) {
+				if (bech32_decode_bits_remaining(&state) < 5)
+					return codec_error(codec, EX_DATAERR, "%s", errmsg(BECH32_TOO_SHORT));
+				if ((ret = bech32_decode_data(&state, &version, 5)) < 0)
+					return codec_error(codec, EX_DATAERR, "%s", errmsg((enum bech32_error) ret));
+				if (codec->version >= 0 && version != codec->version)
+					return codec_error(codec, EX_DATAERR, "version was %d, not %d", version, codec->version);
+				codec->version = (int8_t) version;
+			}
+			*n_out = bech32_decode_bits_remaining(&state) / CHAR_BIT;
+			assert(*n_out <= codec_max_out(codec));
+			if ((ret = bech32_decode_data(&state, out, *n_out * CHAR_BIT)) < 0 ||
+					(ret = bech32_decode_finish(&state, codec->modified ? BECH32M_CONST : 1)) < 0)
+				return codec_error(codec, EX_DATAERR, "%s", errmsg((enum bech32_error) ret));
+		}
+	}
+	else {
+#ifndef DISABLE_BLECH32
+		if (codec->blech) {
+			*n_out = n_hrp + 1/*separator*/ + (codec->version >= 0) + (n_in * CHAR_BIT + 4) / 5 + BLECH32_CHECKSUM_SIZE;
+			assert(*n_out <= codec_max_out(codec));
+			ssize_t ret;
+			struct blech32_encoder_state state;
+			if ((ret = blech32_encode_begin(&state, (char *) out, *n_out, hrp, n_hrp)) < 0)
+				return codec_error(codec, EX_DATAERR, "%s", errmsg((enum bech32_error) ret));
+			if (codec->version >= 0 && (ret = blech32_encode_data(&state, &version, 5)) < 0 ||
+					(ret = blech32_encode_data(&state, in, n_in * CHAR_BIT)) < 0 ||
+					(ret = blech32_encode_finish(&state, codec->modified ? BLECH32M_CONST : 1)) < 0)
+				return codec_error(codec, EX_SOFTWARE, "%s", errmsg((enum bech32_error) ret));
+		}
+		else
+#endif
+		{
+			*n_out = n_hrp + 1/*separator*/ + (codec->version >= 0) + (n_in * CHAR_BIT + 4) / 5 + BECH32_CHECKSUM_SIZE;
+			assert(*n_out <= codec_max_out(codec));
+			ssize_t ret;
+			struct bech32_encoder_state state;
+			if ((ret = bech32_encode_begin(&state, (char *) out, *n_out, hrp, n_hrp)) < 0)
+				return codec_error(codec, EX_DATAERR, "%s", errmsg((enum bech32_error) ret));
+			if (codec->version >= 0 && (ret = bech32_encode_data(&state, &version, 5)) < 0 ||
+					(ret = bech32_encode_data(&state, in, n_in * CHAR_BIT)) < 0 ||
+					(ret = bech32_encode_finish(&state, codec->modified ? BECH32M_CONST : 1)) < 0)
+				return codec_error(codec, EX_SOFTWARE, "%s", errmsg((enum bech32_error) ret));
+		}
+	}
+	return EX_OK;
+}
+
+// Reads lines from stdin, dropping their terminators. Empty lines are skipped.
+static char ** read_lines(size_t *n_lines) {
+	char **lines = NULL;
+	size_t n = 0, n_alloc = 0;
+	char *line = NULL;
+	size_t n_line = 0;
+	for (ssize_t len; (len = getline(&line, &n_line, stdin)) >= 0;) {
+		if (len && line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (!len)
+			continue;
+		if (n == n_alloc && !(lines = reallocarray(lines, n_alloc = n_alloc ? n_alloc * 2 : 1024, sizeof *lines)))
+			err(EX_OSERR, "reallocarray");
+		if (!(lines[n++] = strdup(line)))
+			err(EX_OSERR, "strdup");
+	}
+	if (ferror(stdin))
+		err(EX_IOERR, "error reading from stdin");
+	free(line);
+	*n_lines = n;
+	return lines;
+}
+
+static int build_set(const char *path, unsigned flags) {
+	size_t n_addresses, bad;
+	char **addresses = read_lines(&n_addresses);
+	unsigned char *file;
+	ssize_t n_file = bech32_address_set_build(&file, (const char *const *) addresses, n_addresses, flags, &bad);
+	if (n_file == BECH32_BUFFER_INADEQUATE)
+		errx(EX_OSERR, "out of memory");
+	if (n_file < 0)
+		errx(EX_DATAERR, "%s: %s", addresses[bad], errmsg((enum bech32_error) n_file));
+	FILE *out = fopen(path, "wb");
+	if (!out)
+		err(EX_CANTCREAT, "%s", path);
+	if (fwrite(file, 1, (size_t) n_file, out) < (size_t) n_file || fclose(out) < 0)
+		err(EX_IOERR, "%s", path);
+	free(file);
+	for (size_t i = 0; i < n_addresses; ++i)
+		free(addresses[i]);
+	free(addresses);
+	return EX_OK;
+}
+
+static int query_set(const char *path) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		err(EX_NOINPUT, "%s", path);
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+		err(EX_IOERR, "%s", path);
+	void *data = st.st_size ? mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0) : NULL;
+	if (data == MAP_FAILED)
+		err(EX_IOERR, "%s", path);
+	close(fd);
+	struct bech32_address_set set;
+	if (!data || bech32_address_set_open(&set, data, (size_t) st.st_size) < 0)
+		errx(EX_DATAERR, "%s: not a valid address-set file", path);
+	char *line = NULL;
+	size_t n_line = 0;
+	for (ssize_t len; (len = getline(&line, &n_line, stdin)) >= 0;) {
+		if (len && line[len - 1] == '\n')
+			line[--len] = '\0';
+		if (!len)
+			continue;
+		ssize_t ret = bech32_address_set_contains(&set, line, (size_t) len);
+		if (ret < 0)
+			warnx("%s: %s", line, errmsg((enum bech32_error) ret));
+		else if (ret && puts(line) < 0)
+			err(EX_IOERR, "error writing to stdout");
+	}
+	if (ferror(stdin))
+		err(EX_IOERR, "error reading from stdin");
+	free(line);
+	munmap(data, (size_t) st.st_size);
+	return fflush(stdout) < 0 ? (warn("error writing to stdout"), EX_IOERR) : EX_OK;
+}
+
+enum {
+	GENERATE_BATCH_SIZE = 1 << 14,
+};
+
+// Parses a comma-separated list of witness versions into a mask in which bit v is set iff version v is listed. Returns zero if
+// the list is malformed.
+static uint32_t parse_versions(const char *list) {
+	uint32_t mask = 0;
+	for (char *end;; list = end + 1) {
+		unsigned long version = strtoul(list, &end, 10);
+		if (end == list || *list < '0' || *list > '9' || version > WITNESS_MAX_VERSION)
+			return 0;
+		mask |= UINT32_C(1) << version;
+		if (*end != ',')
+			return *end ? 0 : mask;
+	}
+}
+
+// Parses a comma-separated list of the names of faults into a combination of enum bech32_generate_fault. Returns zero if the
+// list is malformed.
+static unsigned __attribute__ ((__pure__)) parse_faults(const char *list) {
+	static const struct {
+		const char *name;
+		enum bech32_generate_fault fault;
+	} FAULTS[] = {
+		{ "checksum", BECH32_GENERATE_BAD_CHECKSUM },
+		{ "case", BECH32_GENERATE_MIXED_CASE },
+		{ "char", BECH32_GENERATE_ILLEGAL_CHAR },
+	};
+	unsigned faults = 0;
+	for (size_t n;; list += n + 1) {
+		size_t i = 0;
+		for (n = strcspn(list, ","); i < sizeof FAULTS / sizeof *FAULTS; ++i)
+			if (strlen(FAULTS[i].name) == n && memcmp(FAULTS[i].name, list, n) == 0)
+				break;
+		if (i == sizeof FAULTS / sizeof *FAULTS)
+			return 0;
+		faults |= FAULTS[i].fault;
+		if (!list[n])
+			return faults;
+	}
+}
+
+// Writes a corpus of pseudorandom addresses to stdout, either one per line or, if binary, each preceded by its size as a 2-byte
+// big-endian integer.
+static int generate(uint64_t count, const struct bech32_generate_params *params, bool binary) {
+	size_t max_address =
+#ifndef DISABLE_BLECH32
+			params->flags & BECH32_GENERATE_BLECH32 ? BLECH32_MAX_SIZE :
+#endif
+			BECH32_MAX_SIZE;
+	struct bech32_generate_item *items = calloc(GENERATE_BATCH_SIZE, sizeof *items);
+	char *addresses = malloc(GENERATE_BATCH_SIZE * (max_address + 1)), *out = malloc(GENERATE_BATCH_SIZE * (max_address + 2));
+	if (!items || !addresses || !out)
+		err(EX_OSERR, "malloc");
+	for (uint64_t index = 0; index < count;) {
+		size_t n_items = count - index < GENERATE_BATCH_SIZE ? (size_t) (count - index) : GENERATE_BATCH_SIZE, n_out = 0;
+		for (size_t i = 0; i < n_items; ++i)
+			items[i].address = addresses + i * (max_address + 1), items[i].n_address = max_address + 1;
+		bech32_generate(items, n_items, index, params, NULL);
+		for (size_t i = 0; i < n_items; ++i) {
+			if (items[i].ret < 0)
+				errx(EX_USAGE, "%s", errmsg((enum bech32_error) items[i].ret));
+			size_t n_address = (size_t) items[i].ret;
+			if (binary)
+				out[n_out++] = (char) (n_address >> 8), out[n_out++] = (char) n_address;
+			memcpy(out + n_out, items[i].address, n_address);
+			n_out += n_address;
+			if (!binary)
+				out[n_out++] = '\n';
+		}
+		if (fwrite(out, 1, n_out, stdout) < n_out)
+			err(EX_IOERR, "error writing to stdout");
+		index += n_items;
+	}
+	free(out), free(addresses), free(items);
+	return fflush(stdout) < 0 ? (warn("error writing to stdout"), EX_IOERR) : EX_OK;
+}
+
+enum {
+	SCAN_CHUNK_SIZE = 1 << 20,
+	SCAN_MAX_THREADS = 64,
+	SCAN_WINDOW = 4, // chunks in flight per thread
+};
+
+// no valid encoding is longer than this
+static const size_t SCAN_OVERLAP =
+#ifndef DISABLE_BLECH32
+		BLECH32_MAX_SIZE;
+#else
+		BECH32_MAX_SIZE;
+#endif
+
+struct scan_chunk {
+	char *out;
+	size_t n_out, n_matches;
+	bool done;
+};
+
+struct scan_job {
+	const char *path, *data;
+	size_t n_data, n_chunks;
+	struct scan_chunk *chunks;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	size_t next, n_printed, window; // guarded by mutex
+};
+
+static inline bool __attribute__ ((__const__)) is_token_char(char c) {
+	return c >= '0' && c <= '9' || (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+// Scans one chunk of a file and formats its matches. Each chunk is scanned SCAN_OVERLAP bytes past its end so that any
+// encoding starting within it is seen whole; a match that starts or ends inside a token that continues beyond the scanned
+// bytes is a fragment, which is dropped.
+static void scan_chunk(const struct scan_job *job, size_t k) {
+	struct scan_chunk *chunk = &job->chunks[k];
+	size_t begin = k * SCAN_CHUNK_SIZE, end = job->n_data - begin > SCAN_CHUNK_SIZE ? begin + SCAN_CHUNK_SIZE : job->n_data;
+	size_t limit = job->n_data - end > SCAN_OVERLAP ? end + SCAN_OVERLAP : job->n_data;
+	FILE *out = open_memstream(&chunk->out, &chunk->n_out);
+	if (!out)
+		err(EX_OSERR, "open_memstream");
+	struct bech32_scan_match matches[64];
+	for (size_t offset = begin, n_matches, n_scanned; offset < end; offset += n_scanned) {
+		n_matches = bech32_scan(matches, sizeof matches / sizeof *matches, job->data + offset, limit - offset, &n_scanned);
+		for (size_t i = 0; i < n_matches; ++i) {
+			size_t match = offset + matches[i].offset, match_end = match + matches[i].length;
+			if (match >= end)
+				break;
+			if (match == begin && begin && is_token_char(job->data[begin - 1]) ||
+					match_end == limit && limit < job->n_data && is_token_char(job->data[limit]))
+				continue;
+			++chunk->n_matches;
+			if (job->path)
+				fputs(job->path, out), putc(':', out);
+			fprintf(out, "%zu:%.*s\n", match, (int) matches[i].length, job->data + match);
+		}
+	}
+	if (fclose(out) < 0)
+		err(EX_OSERR, "open_memstream");
+}
+
+static void * scan_worker(void *arg) {
+	struct scan_job *job = arg;
+	for (;;) {
+		pthread_mutex_lock(&job->mutex);
+		while (job->next < job->n_chunks && job->next >= job->n_printed + job->window)
+			pthread_cond_wait(&job->cond, &job->mutex);
+		if (job->next == job->n_chunks) {
+			pthread_mutex_unlock(&job->mutex);
+			return NULL;
+		}
+		size_t k = job->next++;
+		pthread_mutex_unlock(&job->mutex);
+		scan_chunk(job, k);
+		pthread_mutex_lock(&job->mutex);
+		job->chunks[k].done = true;
+		pthread_cond_broadcast(&job->cond);
+		pthread_mutex_unlock(&job->mutex);
+	}
+}
+
+// Scans a memory-mapped file for valid encodings, on all processors, and writes them to stdout in order of their offsets.
+// Returns the number of matches, or -1 if the file could not be read.
+static ssize_t scan_file(const char *path, bool show_path) {
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return warn("%s", path), -1;
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+		return warn("%s", path), close(fd), -1;
+	if (!S_ISREG(st.st_mode))
+		return warnx("%s: not a regular file", path), close(fd), -1;
+	void *data = st.st_size ? mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0) : NULL;
+	close(fd);
+	if (data == MAP_FAILED)
+		return warn("%s", path), -1;
+	if (data)
+		madvise(data, (size_t) st.st_size, MADV_WILLNEED);
+	struct scan_job job = {
+		.path = show_path ? path : NULL, .data = data, .n_data = (size_t) st.st_size,
+		.n_chunks = ((size_t) st.st_size + SCAN_CHUNK_SIZE - 1) / SCAN_CHUNK_SIZE,
+		.mutex = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER,
+	};
+	if (!(job.chunks = calloc(job.n_chunks ?: 1, sizeof *job.chunks)))
+		err(EX_OSERR, "calloc");
+	long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t n_threads = n_cpus < 1 ? 1 : n_cpus > SCAN_MAX_THREADS ? SCAN_MAX_THREADS : (size_t) n_cpus;
+	if (n_threads > job.n_chunks)
+		n_threads = job.n_chunks;
+	job.window = n_threads * SCAN_WINDOW;
+	pthread_t threads[SCAN_MAX_THREADS];
+	size_t n_started = 0;
+	if (n_threads > 1)
+		for (; n_started < n_threads; ++n_started)
+			if ((errno = pthread_create(&threads[n_started], NULL, &scan_worker, &job)))
+				err(EX_OSERR, "pthread_create");
+	ssize_t n_matches = 0;
+	for (size_t k = 0; k < job.n_chunks; ++k) {
+		struct scan_chunk *chunk = &job.chunks[k];
+		if (n_started) {
+			pthread_mutex_lock(&job.mutex);
+			while (!chunk->done)
+				pthread_cond_wait(&job.cond, &job.mutex);
+			++job.n_printed;
+			pthread_cond_broadcast(&job.cond);
+			pthread_mutex_unlock(&job.mutex);
+		}
+		else
+			scan_chunk(&job, k);
+		if (fwrite(chunk->out, 1, chunk->n_out, stdout) < chunk->n_out)
+			err(EX_IOERR, "error writing to stdout");
+		free(chunk->out);
+		n_matches += chunk->n_matches;
+	}
+	for (size_t i = 0; i < n_started; ++i)
+		pthread_join(threads[i], NULL);
+	free(job.chunks);
+	if (data)
+		munmap(data, (size_t) st.st_size);
+	return n_matches;
+}
+
+static int scan_files(char *const paths[], size_t n_paths) {
+	bool found = false, failed = false;
+	for (size_t i = 0; i < n_paths; ++i) {
+		ssize_t n_matches = scan_file(paths[i], n_paths > 1);
+		found |= n_matches > 0, failed |= n_matches < 0;
+	}
+	if (fflush(stdout) < 0)
+		return warn("error writing to stdout"), EX_IOERR;
+	return failed ? EX_NOINPUT : found ? EX_OK : 1;
+}
+
+/*
+ * The server's protocol. Each request and each response is a frame: a 4-byte big-endian size followed by a body of that
+ * size. A request body is:
+ *
+ *	op (1 byte): 'e' to encode, 'd' to decode, or 'v' to verify (decode without returning the data)
+ *	flags (1 byte): any of enum serve_flags
+ *	version (1 byte): with SERVE_VERSION, the version field to encode (its least significant 5 bits), or the version, up
+ *		to 127, to assert when decoding unless 0xFF
+ *	n_hrp (2 bytes, big-endian), hrp (n_hrp bytes): the human-readable prefix to encode or to assert when decoding
+ *	payload (the rest): the data to encode (raw, or hex with SERVE_HEX) or the encoding to decode or verify
+ *
+ * A response body is:
+ *
+ *	status (1 byte): 0 on success, or an exit status from sysexits.h on failure
+ *	version (1 byte): the version field decoded, or 0xFF if none
+ *	payload (the rest): the encoding, the decoded data (raw, or hex with SERVE_HEX), or nothing if verifying; or, on
+ *		failure, an error message
+ */
+enum serve_flags {
+	SERVE_MODIFIED = 1 << 0,
+#ifndef DISABLE_BLECH32
+	SERVE_BLECH = 1 << 1,
+#endif
+	SERVE_HEX = 1 << 2,
+	SERVE_VERSION = 1 << 3,
+	SERVE_DETECT = 1 << 4,
+};
+
+enum {
+	SERVE_MAX_FRAME = 4096,
+	SERVE_REQUEST_HEADER_SIZE = 5,
+	SERVE_RESPONSE_HEADER_SIZE = 2,
+};
+
+static bool read_full(int fd, void *buf, size_t n) {
+	for (ssize_t r; n; buf = (char *) buf + r, n -= (size_t) r)
+		if ((r = read(fd, buf, n)) <= 0)
+			if (r < 0 && errno == EINTR)
+				r = 0;
+			else
+				return false;
+	return true;
+}
+
+static bool write_full(int fd, const void *buf, size_t n) {
+	for (ssize_t r; n; buf = (const char *) buf + r, n -= (size_t) r)
+		if ((r = send(fd, buf, n, MSG_NOSIGNAL)) < 0)
+			if (errno == EINTR)
+				r = 0;
+			else
+				return false;
+	return true;
+}
+
+static inline void put_be32(unsigned char out[4], uint32_t x) {
+	out[0] = (unsigned char) (x >> 24), out[1] = (unsigned char) (x >> 16), out[2] = (unsigned char) (x >> 8), out[3] = (unsigned char) x;
+}
+
+static inline uint32_t __attribute__ ((__pure__)) get_be32(const unsigned char in[4]) {
+	return (uint32_t) in[0] << 24 | (uint32_t) in[1] << 16 | (uint32_t) in[2] << 8 | in[3];
+}
+
+// Handles one request. Returns the size of the response body, which is written after the frame header in resp.
+static size_t serve_request(unsigned char resp[], const unsigned char req[], size_t n_req) {
+	unsigned char *body = resp + 4, *payload = body + SERVE_RESPONSE_HEADER_SIZE;
+	struct codec codec = { };
+	int status = EX_USAGE;
+	size_t n_payload = 0;
+	unsigned op, flags;
+	if (n_req < SERVE_REQUEST_HEADER_SIZE || (codec.n_hrp = (size_t) req[3] << 8 | req[4]) > n_req - SERVE_REQUEST_HEADER_SIZE ||
+			(op = req[0]) != 'e' && op != 'd' && op != 'v' ||
+			(flags = req[1]) & ~(unsigned) (SERVE_MODIFIED | SERVE_HEX | SERVE_VERSION | SERVE_DETECT
+#ifndef DISABLE_BLECH32
+				| SERVE_BLECH
+#endif
+			) || op == 'e' && flags & SERVE_DETECT || op != 'e' && req[2] > INT8_MAX && req[2] != 0xFF) {
+		codec_error(&codec, status, "malformed request");
+		goto done;
+	}
+	codec.hrp = (const char *) req + SERVE_REQUEST_HEADER_SIZE;
+	codec.decode = op != 'e', codec.modified = flags & SERVE_MODIFIED, codec.extract_version = flags & SERVE_VERSION;
+	codec.detect = flags & SERVE_DETECT;
+#ifndef DISABLE_BLECH32
+	codec.blech = flags & SERVE_BLECH;
+#endif
+	// only the least significant 5 bits of a version to encode matter, but a version to assert must match exactly, as on the
+	// command line
+	codec.version = !(flags & SERVE_VERSION) ? -1 : op == 'e' ? (int8_t) (req[2] & 0x1F) : req[2] == 0xFF ? -1 : (int8_t) req[2];
+	if ((status = codec_check_hrp(&codec)) != EX_OK)
+		goto done;
+	const unsigned char *in = req + SERVE_REQUEST_HEADER_SIZE + codec.n_hrp;
+	size_t n_in = n_req - SERVE_REQUEST_HEADER_SIZE - codec.n_hrp;
+	unsigned char data[SERVE_MAX_FRAME], out[SERVE_MAX_FRAME];
+	if (!codec.decode && flags & SERVE_HEX) {
+		if ((status = codec_parse_hex(&codec, data, (const char *) in, n_in, &n_in)) != EX_OK)
+			goto done;
+		in = data;
+	}
+	size_t n_out;
+	if ((status = codec_run(&codec, in, n_in, out, &n_out)) != EX_OK)
+		goto done;
+	if (op == 'd')
+		if (flags & SERVE_HEX)
+			n_payload = format_hex((char *) payload, out, n_out);
+		else
+			memcpy(payload, out, n_payload = n_out);
+	else if (op == 'e')
+		memcpy(payload, out, n_payload = n_out);
+done:
+	body[0] = (unsigned char) status;
+	body[1] = status == EX_OK && codec.decode && codec.version >= 0 ? (unsigned char) codec.version : 0xFF;
+	if (status != EX_OK)
+		memcpy(payload, codec.msg, n_payload = strlen(codec.msg));
+	put_be32(resp, (uint32_t) (SERVE_RESPONSE_HEADER_SIZE + n_payload));
+	return SERVE_RESPONSE_HEADER_SIZE + n_payload;
+}
+
+static void * serve_connection(void *arg) {
+	int fd = (int) (intptr_t) arg;
+	unsigned char header[4], req[SERVE_MAX_FRAME], resp[4 + SERVE_RESPONSE_HEADER_SIZE + 2 * SERVE_MAX_FRAME];
+	while (read_full(fd, header, sizeof header)) {
+		uint32_t n_req = get_be32(header);
+		if (n_req > sizeof req || !read_full(fd, req, n_req))
+			break;
+		if (!write_full(fd, resp, 4 + serve_request(resp, req, n_req)))
+			break;
+	}
+	close(fd);
+	return NULL;
+}
+
+static const char *serve_path;
+
+static void serve_stop(int sig) {
+	unlink(serve_path);
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+// Listens on a Unix socket and serves each connection on its own thread until terminated.
+static int serve(const char *path) {
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	if (strlen(path) >= sizeof addr.sun_path)
+		errx(EX_USAGE, "%s: socket path is too long", path);
+	strcpy(addr.sun_path, path);
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		err(EX_OSERR, "socket");
+	if (bind(fd, (const struct sockaddr *) &addr, sizeof addr) < 0) {
+		// replace a stale socket left behind by a server that is no longer running
+		int probe;
+		if (errno != EADDRINUSE || (probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) < 0)
+			err(EX_CANTCREAT, "%s", path);
+		if (connect(probe, (const struct sockaddr *) &addr, sizeof addr) == 0 || errno != ECONNREFUSED)
+			errx(EX_CANTCREAT, "%s: address already in use", path);
+		close(probe);
+		if (unlink(path) < 0 || bind(fd, (const struct sockaddr *) &addr, sizeof addr) < 0)
+			err(EX_CANTCREAT, "%s", path);
+	}
+	if (listen(fd, SOMAXCONN) < 0)
+		err(EX_OSERR, "listen");
+	serve_path = path;
+	signal(SIGINT, &serve_stop);
+	signal(SIGTERM, &serve_stop);
+	pthread_attr_t attr;
+	if ((errno = pthread_attr_init(&attr)) || (errno = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED)))
+		err(EX_OSERR, "pthread_attr_init");
+	for (;;) {
+		int conn = accept4(fd, NULL, NULL, SOCK_CLOEXEC);
+		if (conn < 0) {
+			if (errno != EINTR && errno != ECONNABORTED)
+				warn("accept");
+			continue;
+		}
+		pthread_t thread;
+		if ((errno = pthread_create(&thread, &attr, &serve_connection, (void *) (intptr_t) conn)))
+			warn("pthread_create"), close(conn);
+	}
+}
+
+// Encodes or decodes each of a stream of records on stdin, each preceded by its size as a 2-byte big-endian integer as with
+// --generate --binary, and writes the results to stdout in the same framing. With -v, each decoded record begins with the
+// version field extracted from its encoding.
+static int codec_records(const struct codec *codec) {
+	unsigned char in[UINT16_MAX], out[2 + 1/*version*/ + codec_max_out(codec)];
+	for (uintmax_t index = 1;; ++index) {
+		unsigned char header[2];
+		size_t n_header = fread(header, 1, sizeof header, stdin), n_in = (size_t) header[0] << 8 | header[1];
+		if (n_header == 0 && feof(stdin))
+			break;
+		if (n_header < sizeof header || fread(in, 1, n_in, stdin) < n_in) {
+			if (ferror(stdin))
+				err(EX_IOERR, "error reading from stdin");
+			errx(EX_DATAERR, "record %ju is truncated", index);
+		}
+		struct codec record = *codec;
+		size_t n_out;
+		int status;
+		if ((status = codec_run(&record, in, n_in, out + 2 + codec->extract_version, &n_out)) != EX_OK)
+			errx(status, "record %ju: %s", index, record.msg);
+		if (codec->extract_version)
+			out[2] = (unsigned char) record.version, ++n_out;
+		out[0] = (unsigned char) (n_out >> 8), out[1] = (unsigned char) n_out;
+		if (fwrite(out, 1, 2 + n_out, stdout) < 2 + n_out)
+			err(EX_IOERR, "error writing to stdout");
+	}
+	return fflush(stdout) < 0 ? (warn("error writing to stdout"), EX_IOERR) : EX_OK;
+}
+
+// Reads the input from stdin as the command line would, has the server at the given socket encode or decode it, and
+// writes the output to stdout.
+static int connect_client(const char *path, struct codec *codec, bool hex) {
+	unsigned char req[4 + SERVE_MAX_FRAME], resp[SERVE_RESPONSE_HEADER_SIZE + 2 * SERVE_MAX_FRAME], header[4];
+	if (SERVE_REQUEST_HEADER_SIZE + codec->n_hrp > SERVE_MAX_FRAME)
+		errx(EX_USAGE, errmsg(BECH32_HRP_TOO_LONG));
+	unsigned char *body = req + 4, *in = body + SERVE_REQUEST_HEADER_SIZE + codec->n_hrp;
+	size_t nmax_in = (size_t) (req + sizeof req - in), n_in = fread(in, 1, nmax_in, stdin);
+	if (ferror(stdin))
+		err(EX_IOERR, "error reading from stdin");
+	if (!feof(stdin) && getchar() >= 0)
+		errx(EX_DATAERR, errmsg(BECH32_TOO_LONG));
+	if (codec->decode || hex) {
+		// like the command line, read text only up to the end of the first line
+		unsigned char *nl = memchr(in, '\n', n_in);
+		if (nl)
+			n_in = (size_t) (nl - in);
+	}
+	body[0] = codec->decode ? 'd' : 'e';
+	body[1] = (unsigned char) ((codec->modified ? SERVE_MODIFIED : 0) | (hex ? SERVE_HEX : 0) |
+			(codec->version >= 0 || codec->extract_version ? SERVE_VERSION : 0) | (codec->detect ? SERVE_DETECT : 0)
+#ifndef DISABLE_BLECH32
+			| (codec->blech ? SERVE_BLECH : 0)
+#endif
+			);
+	body[2] = codec->version >= 0 ? (unsigned char) codec->version : 0xFF;
+	body[3] = (unsigned char) (codec->n_hrp >> 8), body[4] = (unsigned char) codec->n_hrp;
+	memcpy(body + SERVE_REQUEST_HEADER_SIZE, codec->hrp, codec->n_hrp);
+	size_t n_body = SERVE_REQUEST_HEADER_SIZE + codec->n_hrp + n_in;
+	put_be32(req, (uint32_t) n_body);
+
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	if (strlen(path) >= sizeof addr.sun_path)
+		errx(EX_USAGE, "%s: socket path is too long", path);
+	strcpy(addr.sun_path, path);
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		err(EX_OSERR, "socket");
+	if (connect(fd, (const struct sockaddr *) &addr, sizeof addr) < 0)
+		err(EX_UNAVAILABLE, "%s", path);
+	uint32_t n_resp;
+	if (!write_full(fd, req, 4 + n_body) || !read_full(fd, header, sizeof header) ||
+			(n_resp = get_be32(header)) < SERVE_RESPONSE_HEADER_SIZE || n_resp > sizeof resp || !read_full(fd, resp, n_resp))
+		errx(EX_PROTOCOL, "%s: no valid response from server", path);
+	close(fd);
+	size_t n_payload = n_resp - SERVE_RESPONSE_HEADER_SIZE;
+	const unsigned char *payload = resp + SERVE_RESPONSE_HEADER_SIZE;
+	if (resp[0] != EX_OK)
+		errx(resp[0], "%.*s", (int) n_payload, payload);
+	if (fwrite(payload, 1, n_payload, stdout) < n_payload || (!codec->decode || hex) && putchar('\n') < 0 || fflush(stdout) < 0)
+		err(EX_IOERR, "error writing to stdout");
+	return codec->extract_version ? resp[1] : EX_OK;
+}
+
 int main(int argc, char *argv[]) {
 	static const struct option longopts[] = {
 		{ .name = "decode", .has_arg = no_argument, .val = 'd' },
@@ -134,12 +992,28 @@ int main(int argc, char *argv[]) {
 		{ .name = "modified", .has_arg = no_argument, .val = 'm' },
 		{ .name = "bech32m", .has_arg = no_argument, .val = 3 }, // retained for backward compatibility
 		{ .name = "exit-version", .has_arg = no_argument, .val = 'v' },
+		{ .name = "build-set", .has_arg = required_argument, .val = 4 },
+		{ .name = "query-set", .has_arg = required_argument, .val = 5 },
+		{ .name = "eytzinger", .has_arg = no_argument, .val = 6 },
+		{ .name = "scan", .has_arg = no_argument, .val = 7 },
+		{ .name = "serve", .has_arg = required_argument, .val = 8 },
+		{ .name = "connect", .has_arg = required_argument, .val = 9 },
+		{ .name = "auto", .has_arg = no_argument, .val = 10 },
+		{ .name = "generate", .has_arg = required_argument, .val = 11 },
+		{ .name = "seed", .has_arg = required_argument, .val = 12 },
+		{ .name = "versions", .has_arg = required_argument, .val = 13 },
+		{ .name = "invalid", .has_arg = required_argument, .val = 14 },
+		{ .name = "faults", .has_arg = required_argument, .val = 15 },
+		{ .name = "binary", .has_arg = no_argument, .val = 16 },
 		{ .name = "help", .has_arg = no_argument, .val = 1 },
 		{ .name = "version", .has_arg = no_argument, .val = 2 },
 		{ }
 	};
 	bool modified = strcmp(program_invocation_short_name, "bech32m") == 0;
-	bool implied = modified, decode = false, hex = false, exit_version = false;
+	bool implied = modified, decode = false, detect = false, hex = false, exit_version = false, eytzinger = false, scan = false;
+	const char *build_path = NULL, *query_path = NULL, *serve_socket = NULL, *connect_path = NULL, *generate_count = NULL;
+	struct bech32_generate_params generate_params = { 0 };
+	bool generate_options = false, binary = false;
 #ifndef DISABLE_BLECH32
 	int blech = 0;
 	if (!implied)
@@ -188,154 +1062,177 @@ int main(int argc, char *argv[]) {
 			case 'v':
 				exit_version = true;
 				break;
+			case 4:
+				build_path = optarg;
+				break;
+			case 5:
+				query_path = optarg;
+				break;
+			case 6:
+				eytzinger = true;
+				break;
+			case 7:
+				scan = true;
+				break;
+			case 8:
+				serve_socket = optarg;
+				break;
+			case 9:
+				connect_path = optarg;
+				break;
+			case 10:
+				detect = true;
+				break;
+			case 11:
+				generate_count = optarg;
+				break;
+			case 12: {
+				char *end;
+				generate_params.seed = strtoull(optarg, &end, 0);
+				if (end == optarg || *end)
+					goto usage_error;
+				generate_options = true;
+				break;
+			}
+			case 13:
+				if (!(generate_params.versions = parse_versions(optarg)))
+					goto usage_error;
+				generate_options = true;
+				break;
+			case 14: {
+				char *end;
+				double percent = strtod(optarg, &end);
+				if (end == optarg || *end || !(percent >= 0 && percent <= 100))
+					goto usage_error;
+				generate_params.invalid = percent / 100;
+				generate_options = true;
+				break;
+			}
+			case 15:
+				if (!(generate_params.faults = parse_faults(optarg)))
+					goto usage_error;
+				generate_options = true;
+				break;
+			case 16:
+				binary = true;
+				break;
 			default:
 			usage_error:
 				print_usage();
 				return EX_USAGE;
 		}
-	if ((decode ? argc - optind > 1 + !exit_version : argc - optind > 2 || exit_version) || optind >= argc)
+	if (generate_count) {
+		char *end;
+		uint64_t count = strtoull(generate_count, &end, 10);
+		if (end == generate_count || *generate_count < '0' || *generate_count > '9' || *end ||
+				scan || build_path || query_path || serve_socket || connect_path || decode || detect || hex || exit_version || eytzinger || modified && !implied)
+			return print_usage(), EX_USAGE;
+		static const char *const DEFAULT_HRPS[] = { "bc" };
+		generate_params.hrps = DEFAULT_HRPS, generate_params.n_hrps = 1;
+#ifndef DISABLE_BLECH32
+		static const char *const DEFAULT_BLECH_HRPS[] = { "el" };
+		if (blech > 0)
+			generate_params.flags |= BECH32_GENERATE_BLECH32, generate_params.hrps = DEFAULT_BLECH_HRPS;
+#endif
+		if (optind < argc)
+			generate_params.hrps = (const char *const *) argv + optind, generate_params.n_hrps = (size_t) (argc - optind);
+		return generate(count, &generate_params, binary);
+	}
+	if (generate_options)
 		return print_usage(), EX_USAGE;
-	const char *const hrp = argv[optind++];
-	size_t n_hrp = strlen(hrp), nmin_hrp, nmax_hrp;
+	if (serve_socket) {
+		if (scan || build_path || query_path || connect_path || decode || detect || hex || exit_version || eytzinger || binary || modified && !implied ||
 #ifndef DISABLE_BLECH32
-	if (blech > 0)
-		nmin_hrp = BLECH32_HRP_MIN_SIZE, nmax_hrp = BLECH32_HRP_MAX_SIZE;
-	else
+				blech > 0 && !implied ||
 #endif
-		nmin_hrp = BECH32_HRP_MIN_SIZE, nmax_hrp = BECH32_HRP_MAX_SIZE;
-	if (n_hrp < nmin_hrp)
-		errx(EX_USAGE, errmsg(BECH32_HRP_TOO_SHORT));
-	if (n_hrp > nmax_hrp)
-		errx(EX_USAGE, errmsg(BECH32_HRP_TOO_LONG));
-	int8_t version = optind < argc ? (int8_t) atoi(argv[optind++]) : -1;
-
-	size_t n_in = 0, nmax_in;
+				optind < argc)
+			return print_usage(), EX_USAGE;
+		return serve(serve_socket);
+	}
+	if (scan) {
+		if (connect_path || build_path || query_path || decode || detect || hex || exit_version || eytzinger || binary || modified && !implied ||
 #ifndef DISABLE_BLECH32
-	if (blech > 0)
-		nmax_in = decode ? BLECH32_MAX_SIZE :
-				(BLECH32_MAX_SIZE - n_hrp - 1/*separator*/ - (version >= 0) - BLECH32_CHECKSUM_SIZE) * 5 / CHAR_BIT;
-	else
+				blech > 0 && !implied ||
 #endif
-		nmax_in = decode ? BECH32_MAX_SIZE :
-				(BECH32_MAX_SIZE - n_hrp - 1/*separator*/ - (version >= 0) - BECH32_CHECKSUM_SIZE) * 5 / CHAR_BIT;
-	unsigned char in[nmax_in];
-	if (decode || hex) {
-		for (int c;;) {
-			if (decode ? (c = getchar()) < 0 || c == '\n' : (c = gethex()) < 0) {
-				if (ferror(stdin))
-					err(EX_IOERR, "error reading from stdin");
-				break;
-			}
-			if (n_in == nmax_in)
-				errx(EX_DATAERR, errmsg(BECH32_TOO_LONG));
-			in[n_in++] = (unsigned char) c;
-		}
+				optind >= argc)
+			return print_usage(), EX_USAGE;
+		return scan_files(argv + optind, (size_t) (argc - optind));
 	}
-	else {
-		n_in = fread(in, 1, nmax_in, stdin);
-		if (ferror(stdin))
-			err(EX_IOERR, "error reading from stdin");
-		if (!feof(stdin) && getchar() >= 0)
-			errx(EX_DATAERR, errmsg(BECH32_TOO_LONG));
+	if (build_path || query_path) {
+		if (build_path && query_path || connect_path || decode || detect || hex || exit_version || binary || modified && !implied || eytzinger && !build_path || optind < argc)
+			return print_usage(), EX_USAGE;
+		if (query_path)
+			return query_set(query_path);
+		unsigned flags = eytzinger ? BECH32_ADDRESS_SET_EYTZINGER : 0;
+#ifndef DISABLE_BLECH32
+		if (blech > 0)
+			flags |= BECH32_ADDRESS_SET_BLECH32;
+#endif
+		return build_set(build_path, flags);
 	}
-
-	size_t n_out = 0, nmax_out;
+	// the variant to detect must not also be specified, although a name that implies one is overridden
+	if (detect && (!decode || modified && !implied
 #ifndef DISABLE_BLECH32
-	if (blech > 0)
-		nmax_out = BLECH32_MAX_SIZE + 1/*'\n'*/;
-	else
+			|| blech > 0 && !implied
 #endif
-		nmax_out = BECH32_MAX_SIZE + 1/*'\n'*/;
-	unsigned char out[nmax_out];
-	if (decode) {
+			))
+		return print_usage(), EX_USAGE;
+	if (eytzinger || binary && (connect_path || hex || exit_version && !decode) || (decode ? argc - optind > 1 + !exit_version : argc - optind > 2 || exit_version) || optind >= argc)
+		return print_usage(), EX_USAGE;
+	struct codec codec = {
+		.hrp = argv[optind++], .decode = decode, .modified = modified, .extract_version = exit_version, .detect = detect,
 #ifndef DISABLE_BLECH32
-		if (blech > 0) {
-			if (n_in < BLECH32_MIN_SIZE)
-				errx(EX_DATAERR, errmsg(BECH32_TOO_SHORT));
-			ssize_t ret;
-			struct blech32_decoder_state state;
-			if ((ret = blech32_decode_begin(&state, (const char *) in, n_in)) < 0)
-				errx(EX_DATAERR, errmsg((enum bech32_error) ret));
-			if ((size_t) ret != n_hrp || strncasecmp((const char *) in, hrp, ret))
-				errx(EX_DATAERR, "human-readable prefix was \"%.*s\", not \"%s\"", (int) ret, in, hrp);
-			if (version >= 0 || exit_version) {
-				if (blech32_decode_bits_remaining(&state) < 5)
-					errx(EX_DATAERR, errmsg(BECH32_TOO_SHORT));
-				int8_t expected_version = version;
-				if ((ret = blech32_decode_data(&state, (unsigned char *) &version, 5)) < 0)
-					errx(EX_DATAERR, errmsg((enum bech32_error) ret));
-				if (expected_version >= 0 && version != expected_version)
-					errx(EX_DATAERR, "version was %d, not %d", version, expected_version);
-			}
-			n_out = blech32_decode_bits_remaining(&state) / CHAR_BIT;
-			assert(n_out <= nmax_out);
-			if ((ret = blech32_decode_data(&state, out, n_out * CHAR_BIT)) < 0 ||
-					(ret = blech32_decode_finish(&state, modified ? BLECH32M_CONST : 1)) < 0)
-				errx(EX_DATAERR, errmsg((enum bech32_error) ret));
-		}
-		else
+		.blech = blech > 0,
 #endif
-		{
-			if (n_in < BECH32_MIN_SIZE)
-				errx(EX_DATAERR, errmsg(BECH32_TOO_SHORT));
-			ssize_t ret;
-			struct bech32_decoder_state state;
-			if ((ret = bech32_decode_begin(&state, (const char *) in, n_in)) < 0)
-				errx(EX_DATAERR, errmsg((enum bech32_error) ret));
-			if ((size_t) ret != n_hrp || strncasecmp((const char *) in, hrp, ret))
-				errx(EX_DATAERR, "human-readable prefix was \"%.*s\", not \"%s\"", (int) ret, in, hrp);
-			if (version >= 0 || exit_version) {
-				if (bech32_decode_bits_remaining(&state) < 5)
-					errx(EX_DATAERR, errmsg(BECH32_TOO_SHORT));
-				int8_t expected_version = version;
-				if ((ret = bech32_decode_data(&state, (unsigned char *) &version, 5)) < 0)
-					errx(EX_DATAERR, errmsg((enum bech32_error) ret));
-				if (expected_version >= 0 && version != expected_version)
-					errx(EX_DATAERR, "version was %d, not %d", version, expected_version);
-			}
-			n_out = bech32_decode_bits_remaining(&state) / CHAR_BIT;
-			assert(n_out <= nmax_out);
-			if ((ret = bech32_decode_data(&state, out, n_out * CHAR_BIT)) < 0 ||
-					(ret = bech32_decode_finish(&state, modified ? BECH32M_CONST : 1)) < 0)
-				errx(EX_DATAERR, errmsg((enum bech32_error) ret));
-		}
+	};
+	codec.n_hrp = strlen(codec.hrp);
+	int status;
+	if ((status = codec_check_hrp(&codec)) != EX_OK)
+		errx(status, "%s", codec.msg);
+	codec.version = optind < argc ? (int8_t) atoi(argv[optind++]) : -1;
+	if (connect_path)
+		return connect_client(connect_path, &codec, hex);
+
+	if (binary)
+		return codec_records(&codec);
+
+	size_t n_in, nmax_in = codec_max_in(&codec);
+	unsigned char in[nmax_in + 1];
+	if (decode) {
+		char line[nmax_in + 2/*'\n', '\0'*/];
+		if ((n_in = read_line(line, sizeof line)) > nmax_in)
+			errx(EX_DATAERR, errmsg(BECH32_TOO_LONG));
+		memcpy(in, line, n_in);
+	}
+	else if (hex) {
+		char line[2 * (nmax_in + 1) + 2/*'\n', '\0'*/];
+		if ((status = codec_parse_hex(&codec, in, line, read_line(line, sizeof line), &n_in)) != EX_OK)
+			errx(status, "%s", codec.msg);
 	}
 	else {
-#ifndef DISABLE_BLECH32
-		if (blech > 0) {
-			n_out = n_hrp + 1/*separator*/ + (version >= 0) + (n_in * CHAR_BIT + 4) / 5 + BLECH32_CHECKSUM_SIZE;
-			assert(n_out <= nmax_out);
-			ssize_t ret;
-			struct blech32_encoder_state state;
-			if ((ret = blech32_encode_begin(&state, (char *) out, n_out, hrp, n_hrp)) < 0)
-				errx(EX_DATAERR, errmsg((enum bech32_error) ret));
-			if (version >= 0 && (ret = blech32_encode_data(&state, (unsigned char *) &version, 5)) < 0 ||
-					(ret = blech32_encode_data(&state, in, n_in * CHAR_BIT)) < 0 ||
-					(ret = blech32_encode_finish(&state, modified ? BLECH32M_CONST : 1)) < 0)
-				errx(EX_SOFTWARE, errmsg((enum bech32_error) ret));
-			out[n_out++] = '\n';
-		}
-		else
-#endif
-		{
-			n_out = n_hrp + 1/*separator*/ + (version >= 0) + (n_in * CHAR_BIT + 4) / 5 + BECH32_CHECKSUM_SIZE;
-			assert(n_out <= nmax_out);
-			ssize_t ret;
-			struct bech32_encoder_state state;
-			if ((ret = bech32_encode_begin(&state, (char *) out, n_out, hrp, n_hrp)) < 0)
-				errx(EX_DATAERR, errmsg((enum bech32_error) ret));
-			if (version >= 0 && (ret = bech32_encode_data(&state, (unsigned char *) &version, 5)) < 0 ||
-					(ret = bech32_encode_data(&state, in, n_in * CHAR_BIT)) < 0 ||
-					(ret = bech32_encode_finish(&state, modified ? BECH32M_CONST : 1)) < 0)
-				errx(EX_SOFTWARE, errmsg((enum bech32_error) ret));
-			out[n_out++] = '\n';
-		}
+		n_in = fread(in, 1, nmax_in, stdin);
+		if (ferror(stdin))
+			err(EX_IOERR, "error reading from stdin");
+		if (!feof(stdin) && getchar() >= 0)
+			errx(EX_DATAERR, errmsg(BECH32_TOO_LONG));
 	}
 
-	if (hex && decode ?
-			fwrite_hex(out, n_out, stdout) < (ssize_t) n_out :
-			fwrite(out, 1, n_out, stdout) < n_out)
+	size_t n_out;
+	unsigned char out[codec_max_out(&codec) + 1/*'\n'*/];
+	if ((status = codec_run(&codec, in, n_in, out, &n_out)) != EX_OK)
+		errx(status, "%s", codec.msg);
+	if (!decode)
+		out[n_out++] = '\n';
+
+	if (hex && decode) {
+		char text[2 * n_out + 1/*'\n'*/];
+		size_t n_text = format_hex(text, out, n_out);
+		text[n_text++] = '\n';
+		if (fwrite(text, 1, n_text, stdout) < n_text)
+			err(EX_IOERR, "error writing to stdout");
+	}
+	else if (fwrite(out, 1, n_out, stdout) < n_out)
 		err(EX_IOERR, "error writing to stdout");
 
-	return exit_version ? version : EX_OK;
+	return exit_version ? codec.version : EX_OK;
 }
@@ -16,8 +16,20 @@
 #	define bech32_decode_bits_remaining blech32_decode_bits_remaining
 #	define bech32_decode_data blech32_decode_data
 #	define bech32_decode_finish blech32_decode_finish
+#	define bech32_decode_finish_detect blech32_decode_finish_detect
+#	define BECH32_CHECKSUM_SIZE BLECH32_CHECKSUM_SIZE
+#	define BECH32_MAX_SIZE BLECH32_MAX_SIZE
+#	define BECH32_STREAM_BUFFER_SIZE BLECH32_STREAM_BUFFER_SIZE
+#	define bech32_stream_decoder_state blech32_stream_decoder_state
+#	define bech32_stream_decode_begin blech32_stream_decode_begin
+#	define bech32_stream_decoded_size blech32_stream_decoded_size
+#	define bech32_stream_decode_data blech32_stream_decode_data
+#	define bech32_stream_decode_finish blech32_stream_decode_finish
 #	define bech32_address_encode blech32_address_encode
 #	define bech32_address_decode blech32_address_decode
+#	define bech32_address_decode_in_place blech32_address_decode_in_place
+#	define bech32_address_encode_batch blech32_address_encode_batch
+#	define bech32_address_decode_batch blech32_address_decode_batch
 #else
 #	ifndef DISABLE_BLECH32
 #		undef BECH32_H_INCLUDED
@@ -27,8 +39,20 @@
 #		define BECH32_H_SECOND_PASS
 #	endif
 #	undef bech32
+#	undef bech32_address_decode_batch
+#	undef bech32_address_encode_batch
+#	undef bech32_address_decode_in_place
 #	undef bech32_address_decode
 #	undef bech32_address_encode
+#	undef bech32_stream_decode_finish
+#	undef bech32_stream_decode_data
+#	undef bech32_stream_decoded_size
+#	undef bech32_stream_decode_begin
+#	undef bech32_stream_decoder_state
+#	undef BECH32_STREAM_BUFFER_SIZE
+#	undef BECH32_MAX_SIZE
+#	undef BECH32_CHECKSUM_SIZE
+#	undef bech32_decode_finish_detect
 #	undef bech32_decode_finish
 #	undef bech32_decode_data
 #	undef bech32_decode_bits_remaining
@@ -44,6 +68,17 @@
 #	undef bech32_checksum_t
 #endif
 
+#ifndef BECH32_API
+#	ifdef BECH32_HEADER_ONLY
+#		ifndef __cplusplus
+#			error "BECH32_HEADER_ONLY requires a C++ compiler, as the codecs are instantiated from the templates in bech32_bch.h"
+#		endif
+#		define BECH32_API static inline
+#	else
+#		define BECH32_API
+#	endif
+#endif
+
 #include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -75,6 +110,8 @@ static const size_t
 	SEGWIT_ADDRESS_MIN_SIZE = BECH32_HRP_MIN_SIZE + 1/*separator*/ + 1/*version*/ +
 			((WITNESS_PROGRAM_MIN_SIZE * CHAR_BIT + 4) / 5) + BECH32_CHECKSUM_SIZE;
 
+enum { BECH32_STREAM_BUFFER_SIZE = 90/*BECH32_MAX_SIZE*/ };
+
 #else // defined(INCLUDED_FOR_BLECH32)
 
 typedef uint_fast64_t blech32_checksum_t;
@@ -97,6 +134,8 @@ static const size_t
 	BLINDING_ADDRESS_MIN_SIZE = BLECH32_HRP_MIN_SIZE + 1/*separator*/ + 1/*version*/ +
 			((BLINDING_PROGRAM_MIN_SIZE * CHAR_BIT + 4) / 5) + BLECH32_CHECKSUM_SIZE;
 
+enum { BLECH32_STREAM_BUFFER_SIZE = 1000/*BLECH32_MAX_SIZE*/ };
+
 #endif // defined(INCLUDED_FOR_BLECH32)
 
 #ifndef BECH32_H_SECOND_PASS
@@ -125,6 +164,71 @@ enum bech32_error {
 	SEGWIT_PROGRAM_ILLEGAL_SIZE = -15,
 };
 
+
+static const size_t
+	/**
+	 * @brief The number of items below which the batch functions do all of their work on the calling thread.
+	 *
+	 * Encoding or decoding an address takes a few hundred nanoseconds, whereas waking the worker threads and joining them
+	 * again costs some tens of microseconds, so parallelism does not pay for itself on smaller batches.
+	 */
+	BECH32_BATCH_THRESHOLD = 1024,
+	/**
+	 * @brief The number of items that the batch functions hand out to a thread at a time.
+	 *
+	 * A chunk of items together with the addresses and programs they reference fits comfortably in a core's L1 data cache.
+	 */
+	BECH32_BATCH_CHUNK_SIZE = 128;
+
+/**
+ * @brief An address to be encoded by bech32_address_encode_batch() or blech32_address_encode_batch().
+ *
+ * The fields correspond to the parameters and return value of bech32_address_encode().
+ */
+struct bech32_address_encode_item {
+	char *address;
+	size_t n_address;
+	const unsigned char *program;
+	size_t n_program;
+	const char *hrp;
+	size_t n_hrp;
+	unsigned version;
+	ssize_t ret;
+};
+
+/**
+ * @brief An address to be decoded by bech32_address_decode_batch() or blech32_address_decode_batch().
+ *
+ * The fields correspond to the parameters and return value of bech32_address_decode().
+ */
+struct bech32_address_decode_item {
+	unsigned char *program;
+	size_t n_program;
+	const char *address;
+	size_t n_address;
+	size_t n_hrp;
+	unsigned version;
+	ssize_t ret;
+};
+
+/**
+ * @brief A caller-supplied means of running the tasks of a batch in parallel.
+ */
+struct bech32_executor {
+
+	/**
+	 * @brief Calls @p task(@p arg, @c i) once for each @c i in [0, @p n_tasks), in any order and on any threads, and returns
+	 * only after all of the calls have returned.
+	 */
+	void (*run)(void *ctx, void (*task)(void *arg, size_t i), void *arg, size_t n_tasks);
+
+	/**
+	 * @brief An opaque pointer to pass to #run.
+	 */
+	void *ctx;
+
+};
+
 #endif // !defined(BECH32_H_SECOND_PASS)
 
 
@@ -169,7 +273,7 @@ struct bech32_encoder_state {
  * @param n_pad The number of excess bytes to include in the returned size.
  * @return The size of the specified Bech32 encoding, or @c SIZE_MAX upon overflow.
  */
-size_t bech32_encoded_size(
+BECH32_API size_t bech32_encoded_size(
 		size_t n_hrp,
 		size_t nbits_in,
 		size_t n_pad)
@@ -190,7 +294,7 @@ size_t bech32_encoded_size(
  * @c BECH32_HRP_ILLEGAL_CHAR because the human-readable prefix contains an illegal character, or
  * @c BECH32_BUFFER_INADEQUATE because @p n_out is too small.
  */
-enum bech32_error bech32_encode_begin(
+BECH32_API enum bech32_error bech32_encode_begin(
 		struct bech32_encoder_state *restrict state,
 		char *restrict out,
 		size_t n_out,
@@ -209,7 +313,7 @@ enum bech32_error bech32_encode_begin(
  * @return 0 if the given data bits were consumed, or a negative number if an error occurred, which may be
  * @c BECH32_BUFFER_INADEQUATE because insufficient space remains in the output buffer.
  */
-enum bech32_error bech32_encode_data(
+BECH32_API enum bech32_error bech32_encode_data(
 		struct bech32_encoder_state *restrict state,
 		const unsigned char *restrict in,
 		size_t nbits_in)
@@ -225,7 +329,7 @@ enum bech32_error bech32_encode_data(
  * @c BECH32_BUFFER_INADEQUATE because insufficient space remains in the output buffer or
  * @c BECH32_CHECKSUM_FAILURE because the encoding failed its internal checksum check (due to a software bug or hardware failure).
  */
-enum bech32_error bech32_encode_finish(
+BECH32_API enum bech32_error bech32_encode_finish(
 		struct bech32_encoder_state *restrict state,
 		bech32_constant_t constant)
 	__attribute__ ((__access__ (read_write, 1), __nonnull__, __nothrow__, __warn_unused_result__));
@@ -282,7 +386,7 @@ struct bech32_decoder_state {
  * @c BECH32_ILLEGAL_CHAR because the encoding contains an illegal character, or
  * @c BECH32_MIXED_CASE because the encoding uses mixed case.
  */
-ssize_t bech32_decode_begin(
+BECH32_API ssize_t bech32_decode_begin(
 		struct bech32_decoder_state *restrict state,
 		const char *restrict in,
 		size_t n_in)
@@ -303,6 +407,8 @@ bech32_decode_bits_remaining(const struct bech32_decoder_state *restrict state)
  * @param[in,out] state A pointer to the decoder state, which must previously have been initialized by a call to
  * bech32_decode_begin().
  * @param[out] out A pointer to a buffer into which the decoder is to place the decoded data.
+ * It may point into the encoding being decoded, at or before the first character not yet consumed, so as to decode the data in
+ * place, as each byte then overwrites only characters that have already been consumed.
  * @param nbits_out The number of data bits to place in the buffer at @p out.
  * If this is not an integer multiple of @c CHAR_BIT, then the valid bits in the last output byte will be aligned to the least
  * significant bit.
@@ -310,9 +416,9 @@ bech32_decode_bits_remaining(const struct bech32_decoder_state *restrict state)
  * @c BECH32_BUFFER_INADEQUATE because insufficient characters remain in the input buffer or
  * @c BECH32_ILLEGAL_CHAR because the decoder encountered an illegal character in the encoding.
  */
-enum bech32_error bech32_decode_data(
+BECH32_API enum bech32_error bech32_decode_data(
 		struct bech32_decoder_state *restrict state,
-		unsigned char *restrict out,
+		unsigned char *out,
 		size_t nbits_out)
 	__attribute__ ((__access__ (read_write, 1), __access__ (write_only, 2), __nonnull__, __nothrow__, __warn_unused_result__));
 
@@ -328,11 +434,169 @@ enum bech32_error bech32_decode_data(
  * @c BECH32_ILLEGAL_CHAR because the decoder encountered an illegal character in the encoding, or
  * @c BECH32_CHECKSUM_FAILURE because checksum verification failed.
  */
-ssize_t bech32_decode_finish(
+BECH32_API ssize_t bech32_decode_finish(
 		struct bech32_decoder_state *restrict state,
 		bech32_constant_t constant)
 	__attribute__ ((__access__ (read_write, 1), __nonnull__, __nothrow__, __warn_unused_result__));
 
+/**
+ * @brief Finishes a Bech32 decoding, determining from the checksum whether the encoding is of the original Bech32 specification
+ * or of Bech32m.
+ * @param[in,out] state A pointer to the decoder state, which must previously have been initialized by a call to
+ * bech32_decode_begin().
+ * @param[out] constant A pointer to a variable that is to receive the constant that the checksum matched, which is 1 or
+ * @c BECH32M_CONST.
+ * @return As for bech32_decode_finish(), with @c BECH32_CHECKSUM_FAILURE meaning that the checksum matched neither constant.
+ */
+BECH32_API ssize_t bech32_decode_finish_detect(
+		struct bech32_decoder_state *restrict state,
+		bech32_constant_t *restrict constant)
+	__attribute__ ((__access__ (read_write, 1), __access__ (write_only, 2), __nonnull__, __nothrow__, __warn_unused_result__));
+
+
+
+/**
+ * @brief The state of a streaming Bech32 decoder.
+ *
+ * A streaming decoder accepts an encoding in arbitrary chunks and produces decoded bytes as soon as they are known, using a
+ * bounded amount of memory regardless of the length of the encoding.
+ */
+struct bech32_stream_decoder_state {
+
+	/**
+	 * @brief The number of characters that have been consumed by the decoder.
+	 */
+	size_t n_in;
+
+	/**
+	 * @brief The maximum size of the encoding, as passed to bech32_stream_decode_begin().
+	 */
+	size_t n_max;
+
+	/**
+	 * @brief The size of the human-readable prefix at #buf, or 0 if the separator has not yet been located.
+	 */
+	size_t n_hrp;
+
+	/**
+	 * @brief The number of characters at #buf.
+	 */
+	size_t n_buf;
+
+	/**
+	 * @brief The number of characters held back in #tail because they may belong to the checksum.
+	 */
+	size_t n_tail;
+
+	/**
+	 * @brief The number of bits that have been consumed by the decoder but that do not yet appear in the output.
+	 *
+	 * After a successful call to bech32_stream_decode_finish(), this is the number of padding bits.
+	 */
+	size_t nbits;
+
+	/**
+	 * @brief The bits that have been consumed by the decoder but that do not yet appear in the output.
+	 *
+	 * Only the #nbits least significant bits of this field are valid.
+	 */
+	bech32_checksum_t bits;
+
+	/**
+	 * @brief The 5-bit values of the #n_tail most recently consumed data characters.
+	 */
+	bech32_checksum_t tail;
+
+	/**
+	 * @brief The intermediate checksum state.
+	 */
+	bech32_checksum_t chk;
+
+	/**
+	 * @brief Bit 0 is set if a lowercase letter has been consumed, and bit 1 is set if an uppercase letter has been consumed.
+	 */
+	unsigned cases;
+
+	/**
+	 * @brief The leading characters of the encoding, which hold the human-readable prefix once it has been located.
+	 */
+	char buf[BECH32_STREAM_BUFFER_SIZE];
+
+};
+
+/**
+ * @brief Begins a streaming Bech32 decoding.
+ * @param[out] state A pointer to the decoder state to initialize.
+ * @param n_max The maximum size of the encoding in characters.
+ * Pass @c BECH32_MAX_SIZE to enforce the limit of the Bech32 specification or @c SIZE_MAX for no limit.
+ */
+BECH32_API void bech32_stream_decode_begin(
+		struct bech32_stream_decoder_state *restrict state,
+		size_t n_max)
+	__attribute__ ((__access__ (write_only, 1), __nonnull__, __nothrow__));
+
+/**
+ * @brief Returns the size of the output buffer required to decode the specified number of additional characters.
+ * @param[in] state A pointer to the decoder state, which must previously have been initialized by a call to
+ * bech32_stream_decode_begin().
+ * @param n_in The number of characters to be passed to bech32_stream_decode_data(), or 0 to calculate the size required by
+ * bech32_stream_decode_finish().
+ */
+static inline size_t
+__attribute__ ((__access__ (read_only, 1), __nonnull__, __nothrow__, __pure__))
+bech32_stream_decoded_size(const struct bech32_stream_decoder_state *restrict state, size_t n_in) {
+	return ((state->n_hrp ? 0 : state->n_buf) + n_in) * 5 / CHAR_BIT + 1;
+}
+
+/**
+ * @brief Pushes a chunk of an encoding into the streaming Bech32 decoder.
+ * @param[in,out] state A pointer to the decoder state, which must previously have been initialized by a call to
+ * bech32_stream_decode_begin().
+ * @param[out] out A pointer to a buffer into which the decoder is to write any bytes that become known.
+ * @param n_out The size of the buffer at @p out, which must be at least bech32_stream_decoded_size(@p state, @p n_in).
+ * @param[in] in A pointer to the next chunk of the encoding.
+ * @param n_in The size of the chunk at @p in.
+ * @return The number of bytes written to @p out, or a negative number if an error occurred, which may be
+ * @c BECH32_BUFFER_INADEQUATE because @p n_out is too small (in which case no input was consumed),
+ * @c BECH32_TOO_LONG because the encoding exceeds the maximum size,
+ * @c BECH32_NO_SEPARATOR because no separator was found where the human-readable prefix could end,
+ * @c BECH32_HRP_TOO_SHORT because the human-readable prefix is empty,
+ * @c BECH32_HRP_TOO_LONG because the human-readable prefix is too long,
+ * @c BECH32_HRP_ILLEGAL_CHAR because the human-readable prefix contains an illegal character, or
+ * @c BECH32_ILLEGAL_CHAR because the encoding contains an illegal character.
+ *
+ * The bytes produced are not authenticated until bech32_stream_decode_finish() has verified the checksum.
+ */
+BECH32_API ssize_t bech32_stream_decode_data(
+		struct bech32_stream_decoder_state *restrict state,
+		unsigned char *restrict out,
+		size_t n_out,
+		const char *restrict in,
+		size_t n_in)
+	__attribute__ ((__access__ (read_write, 1), __access__ (write_only, 2), __access__ (read_only, 4), __nonnull__, __nothrow__, __warn_unused_result__));
+
+/**
+ * @brief Finishes a streaming Bech32 decoding.
+ * @param[in,out] state A pointer to the decoder state, which must previously have been initialized by a call to
+ * bech32_stream_decode_begin().
+ * @param[out] out A pointer to a buffer into which the decoder is to write any remaining bytes.
+ * @param n_out The size of the buffer at @p out, which must be at least bech32_stream_decoded_size(@p state, 0).
+ * @param constant The constant to add to the checksum.
+ * It should be 1 for the original Bech32 specification or @c BECH32M_CONST for Bech32m.
+ * @return The number of bytes written to @p out if the decoder successfully finished the decoding and verified the checksum,
+ * or a negative number if an error occurred, which may be any of the errors returned by bech32_stream_decode_data() or
+ * @c BECH32_TOO_SHORT because the encoding is too short,
+ * @c BECH32_MIXED_CASE because the encoding uses mixed case,
+ * @c BECH32_PADDING_ERROR because of a padding error (5 or more bits remain unconsumed or an unconsumed bit is set), or
+ * @c BECH32_CHECKSUM_FAILURE because checksum verification failed.
+ */
+BECH32_API ssize_t bech32_stream_decode_finish(
+		struct bech32_stream_decoder_state *restrict state,
+		unsigned char *restrict out,
+		size_t n_out,
+		bech32_constant_t constant)
+	__attribute__ ((__access__ (read_write, 1), __access__ (write_only, 2), __nonnull__, __nothrow__, __warn_unused_result__));
+
 
 /**
  * @brief Encodes a Segregated Witness program into a Bech32 address.
@@ -358,7 +622,7 @@ ssize_t bech32_decode_finish(
  * @c BECH32_HRP_ILLEGAL_CHAR because the human-readable prefix contains an illegal character, or
  * @c BECH32_CHECKSUM_FAILURE because the encoding failed its internal checksum check (due to a software bug or hardware failure).
  */
-ssize_t bech32_address_encode(
+BECH32_API ssize_t bech32_address_encode(
 		char *restrict address,
 		size_t n_address,
 		const unsigned char *restrict program,
@@ -397,7 +661,7 @@ ssize_t bech32_address_encode(
  * @c BECH32_PADDING_ERROR because of a padding error, or
  * @c BECH32_CHECKSUM_FAILURE because checksum verification failed.
  */
-ssize_t bech32_address_decode(
+BECH32_API ssize_t bech32_address_decode(
 		unsigned char *restrict program,
 		size_t n_program,
 		const char *restrict address,
@@ -406,96 +670,696 @@ ssize_t bech32_address_decode(
 		unsigned *restrict version)
 	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 3), __access__ (write_only, 5), __access__ (write_only, 6), __nonnull__, __nothrow__, __warn_unused_result__));
 
+/**
+ * @brief Decodes a Bech32 address in place, overwriting it with its Segregated Witness program.
+ * @param[in,out] address A pointer to the Bech32 address to decode.
+ * If the decoding was successful, then the witness program occupies the buffer beginning immediately after the separator, that
+ * is, at @p address + *@p n_hrp + 1, and the human-readable prefix is left intact. Otherwise, the data characters of the
+ * address may have been overwritten.
+ * @param n_address The size of the address at @p address.
+ * @param[out] n_hrp A pointer to a variable that is to receive the size of the human-readable prefix in characters.
+ * @param[out] version A pointer to a variable that is to receive the witness version.
+ * @return As for bech32_address_decode(), except that @c BECH32_BUFFER_INADEQUATE is not possible.
+ */
+BECH32_API ssize_t bech32_address_decode_in_place(
+		char *address,
+		size_t n_address,
+		size_t *restrict n_hrp,
+		unsigned *restrict version)
+	__attribute__ ((__access__ (read_write, 1, 2), __access__ (write_only, 3), __access__ (write_only, 4), __nonnull__, __nothrow__, __warn_unused_result__));
 
-#ifndef BECH32_H_SECOND_PASS
-ssize_t segwit_address_encode // line break so we don't generate man pages for these deprecated symbols
-	(char *restrict, size_t, const unsigned char *restrict, size_t, const char *restrict, size_t, unsigned)
-	__attribute__ ((__deprecated__ ("renamed to bech32_address_encode")));
-ssize_t segwit_address_decode // ditto
-	(unsigned char *restrict, size_t, const char *restrict, size_t, size_t *restrict, unsigned *restrict)
-	__attribute__ ((__deprecated__ ("renamed to bech32_address_decode")));
-#endif
+/**
+ * @brief Encodes a batch of Segregated Witness programs into Bech32 addresses, in parallel if the batch is large.
+ * @param[in,out] items A pointer to an array of items, each of which specifies the arguments to a call of
+ * bech32_address_encode() and receives its return value in its @c ret field.
+ * @param n_items The number of items at @p items.
+ * If it is less than @c BECH32_BATCH_THRESHOLD, then all of the items are encoded on the calling thread.
+ * @param[in] executor A pointer to an executor that is to run the chunks of the batch, or null to use the library's internal
+ * work-stealing thread pool, which has one thread per online processor (up to a small limit) and is started on first use.
+ * If the internal pool is already busy with a batch from another thread, then this batch is encoded on the calling thread.
+ */
+void bech32_address_encode_batch(
+		struct bech32_address_encode_item *restrict items,
+		size_t n_items,
+		const struct bech32_executor *restrict executor)
+	__attribute__ ((__access__ (read_write, 1, 2), __access__ (read_only, 3), __nothrow__));
 
+/**
+ * @brief Decodes a batch of Bech32 addresses into Segregated Witness programs, in parallel if the batch is large.
+ * @param[in,out] items A pointer to an array of items, each of which specifies the arguments to a call of
+ * bech32_address_decode() and receives its outputs in its @c n_hrp and @c version fields and its return value in its @c ret
+ * field.
+ * @param n_items The number of items at @p items.
+ * If it is less than @c BECH32_BATCH_THRESHOLD, then all of the items are decoded on the calling thread.
+ * @param[in] executor A pointer to an executor that is to run the chunks of the batch, or null to use the library's internal
+ * work-stealing thread pool.
+ * If the internal pool is already busy with a batch from another thread, then this batch is decoded on the calling thread.
+ */
+void bech32_address_decode_batch(
+		struct bech32_address_decode_item *restrict items,
+		size_t n_items,
+		const struct bech32_executor *restrict executor)
+	__attribute__ ((__access__ (read_write, 1, 2), __access__ (read_only, 3), __nothrow__));
 
-#ifdef __cplusplus
-} // extern "C"
-# undef restrict
+#ifndef INCLUDED_FOR_BLECH32
 
+/**
+ * @brief Encodes a 20-byte Segregated Witness program, such as a P2WPKH program, into a Bech32 address.
+ *
+ * This function behaves exactly as bech32_address_encode() does with @p n_program equal to 20, but it is faster, as the
+ * layout of the address is known at compile time.
+ */
+BECH32_API ssize_t bech32_address_encode_20(
+		char *restrict address,
+		size_t n_address,
+		const unsigned char *restrict program,
+		const char *restrict hrp,
+		size_t n_hrp,
+		unsigned version)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 3), __access__ (read_only, 4), __nonnull__, __nothrow__, __warn_unused_result__));
 
-#ifndef BECH32_H_SECOND_PASS
+/**
+ * @brief Encodes a 32-byte Segregated Witness program, such as a P2WSH or P2TR program, into a Bech32 address.
+ *
+ * This function behaves exactly as bech32_address_encode() does with @p n_program equal to 32, but it is faster, as the
+ * layout of the address is known at compile time.
+ */
+BECH32_API ssize_t bech32_address_encode_32(
+		char *restrict address,
+		size_t n_address,
+		const unsigned char *restrict program,
+		const char *restrict hrp,
+		size_t n_hrp,
+		unsigned version)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 3), __access__ (read_only, 4), __nonnull__, __nothrow__, __warn_unused_result__));
 
-#include <climits>
-#include <cstddef>
-#include <stdexcept>
-#include <string>
-#include <string_view>
-#include <tuple>
-#include <vector>
+/**
+ * @brief Decodes a Bech32 address into a 20-byte Segregated Witness program, such as a P2WPKH program.
+ * @param[out] program A pointer to a buffer of 20 bytes into which the witness program is to be written.
+ * @return 20 if the decoding was successful, or a negative number if an error occurred, which may be any that
+ * bech32_address_decode() may return, or @c SEGWIT_PROGRAM_ILLEGAL_SIZE if the address is valid but encodes a witness program of
+ * another size.
+ *
+ * The other parameters are as for bech32_address_decode(). This function is faster than bech32_address_decode(), as the layout
+ * of the address is known at compile time.
+ */
+BECH32_API ssize_t bech32_address_decode_20(
+		unsigned char *restrict program,
+		const char *restrict address,
+		size_t n_address,
+		size_t *restrict n_hrp,
+		unsigned *restrict version)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __access__ (write_only, 4), __access__ (write_only, 5), __nonnull__, __nothrow__, __warn_unused_result__));
 
-namespace bech32 {
+/**
+ * @brief Decodes a Bech32 address into a 32-byte Segregated Witness program, such as a P2WSH or P2TR program.
+ * @param[out] program A pointer to a buffer of 32 bytes into which the witness program is to be written.
+ * @return 32 if the decoding was successful, or a negative number if an error occurred, which may be any that
+ * bech32_address_decode() may return, or @c SEGWIT_PROGRAM_ILLEGAL_SIZE if the address is valid but encodes a witness program of
+ * another size.
+ *
+ * The other parameters are as for bech32_address_decode(). This function is faster than bech32_address_decode(), as the layout
+ * of the address is known at compile time.
+ */
+BECH32_API ssize_t bech32_address_decode_32(
+		unsigned char *restrict program,
+		const char *restrict address,
+		size_t n_address,
+		size_t *restrict n_hrp,
+		unsigned *restrict version)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __access__ (write_only, 4), __access__ (write_only, 5), __nonnull__, __nothrow__, __warn_unused_result__));
 
+#endif // !defined(INCLUDED_FOR_BLECH32)
 
-class Error : public std::runtime_error {
 
-public:
-	enum ::bech32_error error;
+#ifndef BECH32_H_SECOND_PASS
 
-public:
-	explicit Error(enum ::bech32_error error);
+/**
+ * @brief The variants of the encoding that bech32_scan() and bech32_detect() can find.
+ */
+enum bech32_variant {
+	BECH32_VARIANT_BECH32 = 1,
+	BECH32_VARIANT_BECH32M = 2,
+#ifndef DISABLE_BLECH32
+	BECH32_VARIANT_BLECH32 = 3,
+	BECH32_VARIANT_BLECH32M = 4,
+#endif
+};
 
+/**
+ * @brief A valid encoding found by bech32_scan().
+ */
+struct bech32_scan_match {
+	size_t offset; ///< the offset of the encoding from the start of the scanned buffer
+	size_t length; ///< the size of the encoding
+	enum bech32_variant variant; ///< the variant whose checksum the encoding satisfies
 };
 
+/**
+ * @brief Finds the valid encodings in a buffer of arbitrary text or binary data.
+ * @param[out] matches A pointer to an array that is to receive the matches, in order of their offsets.
+ * @param n_matches The number of elements in the array at @p matches.
+ * @param[in] in A pointer to the buffer to scan.
+ * @param n_in The size of the buffer at @p in.
+ * @param[out] n_scanned A pointer to a variable that is to receive the number of bytes scanned.
+ * This is less than @p n_in only if the array at @p matches was filled, in which case the scan may be resumed at
+ * <tt>@p in + *@p n_scanned</tt>, which lies at the end of the last match.
+ * @return The number of matches written to @p matches.
+ *
+ * The buffer is split into tokens, which are maximal runs of ASCII letters and digits; the ends of the buffer also delimit
+ * tokens. Every token that is a complete, valid encoding is reported, with its variant determined by its checksum. Hence
+ * encodings whose human-readable prefixes contain characters other than letters and digits are not found. Tokens are located
+ * 16 bytes at a time using vector instructions where available, and only those of plausible size that contain a separator are
+ * checksummed, without being decoded or copied.
+ */
+size_t bech32_scan(
+		struct bech32_scan_match *restrict matches,
+		size_t n_matches,
+		const char *restrict in,
+		size_t n_in,
+		size_t *restrict n_scanned)
+	__attribute__ ((__access__ (write_only, 1, 2), __access__ (read_only, 3, 4), __access__ (write_only, 5), __nonnull__ (5), __nothrow__));
 
-} // namespace bech32
+/**
+ * @brief Determines the variant of an encoding from its checksum without decoding it.
+ * @param[in] in A pointer to the encoding.
+ * @param n_in The size of the encoding at @p in.
+ * @return The #bech32_variant whose checksum the encoding satisfies, or a negative number if an error occurred, which may be
+ * any of the errors returned by bech32_decode_begin() or blech32_decode_begin() or @c BECH32_CHECKSUM_FAILURE because the
+ * encoding satisfies no variant's checksum.
+ *
+ * An encoding that could be either Bech32 or Blech32 has the residues of both checksums computed in the same pass over its
+ * characters, so detecting its variant costs about as much as verifying a known one.
+ */
+ssize_t bech32_detect(
+		const char *restrict in,
+		size_t n_in)
+	__attribute__ ((__access__ (read_only, 1, 2), __nonnull__, __nothrow__, __pure__, __warn_unused_result__));
 
 #endif // !defined(BECH32_H_SECOND_PASS)
 
-#ifdef INCLUDED_FOR_BLECH32
-#	define bech32 blech32
-#endif
-namespace bech32 {
-
 
-class Encoder {
+#ifndef BECH32_H_SECOND_PASS
 
-private:
-	struct ::bech32_encoder_state state;
-	std::string out;
+/**
+ * @brief Flags for bech32_address_set_build().
+ */
+enum bech32_address_set_flags {
 
-public:
-#if __cpp_lib_constexpr_string >= 201907L
-	constexpr
+#ifndef DISABLE_BLECH32
+	/**
+	 * @brief The file holds blinding addresses, which are built and queried using Blech32/Blech32m.
+	 */
+	BECH32_ADDRESS_SET_BLECH32 = 1 << 0,
 #endif
-	Encoder() noexcept : state() { }
 
-	explicit Encoder(std::string_view hrp, size_t nbits_reserve = 0) {
-		this->reset(hrp, nbits_reserve);
-	}
-
-public:
-	void reset(std::string_view hrp, size_t nbits_reserve = 0);
+	/**
+	 * @brief The records of each group are stored in Eytzinger (breadth-first) order rather than in sorted order, which
+	 * makes lookups in large groups friendlier to the cache and the branch predictor.
+	 */
+	BECH32_ADDRESS_SET_EYTZINGER = 1 << 1,
 
-	void write(const void *in, size_t nbits_in);
+};
 
-	std::string finish(bech32_constant_t constant = BECH32M_CONST);
+static const uint32_t BECH32_ADDRESS_SET_FORMAT = 1;
 
+/**
+ * @brief The header at the start of an address-set file.
+ *
+ * An address-set file is a header, followed by an array of #n_groups group descriptors, followed by the human-readable
+ * prefixes of the groups, followed by the records of the groups. All multi-byte integers are in the byte order of the host
+ * that built the file; a reader on a host of the opposite byte order will not recognize #format.
+ */
+struct bech32_address_set_header {
+	char magic[8]; ///< "BECH32AS"
+	uint32_t format; ///< @c BECH32_ADDRESS_SET_FORMAT
+	uint32_t flags; ///< a bitwise combination of #bech32_address_set_flags
+	uint64_t n_groups; ///< the number of group descriptors following the header
 };
 
+/**
+ * @brief The descriptor of a group of records in an address-set file.
+ *
+ * A group holds the distinct witness programs of all the addresses having a particular human-readable prefix (in lowercase),
+ * witness version, and program size. Each record is just the witness program, and the records are sorted by
+ * <tt>memcmp</tt>, either in order or in Eytzinger order. Groups are sorted by prefix size, prefix, version, and program
+ * size.
+ */
+struct bech32_address_set_group {
+	uint64_t offset; ///< the offset of the group's first record from the start of the file
+	uint64_t n_records; ///< the number of records in the group
+	uint64_t hrp_offset; ///< the offset of the group's human-readable prefix from the start of the file
+	uint16_t n_hrp; ///< the size of the group's human-readable prefix
+	uint8_t version; ///< the witness version of the group's addresses
+	uint8_t n_program; ///< the size of the group's witness programs, which is also the size of each record
+	uint32_t reserved; ///< zero
+};
 
-class Decoder {
-
-private:
-	struct ::bech32_decoder_state state;
-	std::string_view hrp;
+/**
+ * @brief A read-only view of an address-set file in memory, such as one mapped with @c mmap(2).
+ */
+struct bech32_address_set {
+	const unsigned char *data; ///< the start of the file
+	size_t n_data; ///< the size of the file
+	uint32_t flags; ///< the flags from the file's header
+	size_t n_groups; ///< the number of groups in the file
+	const struct bech32_address_set_group *groups; ///< the group descriptors in the file
+};
 
-public:
-	constexpr Decoder() noexcept : state() { }
+/**
+ * @brief Builds an address-set file from a list of SegWit addresses.
+ * @param[out] out A pointer to a variable that is to receive a pointer to the built file, which the caller must release using
+ * @c free(3).
+ * @param[in] addresses A pointer to an array of pointers to the null-terminated addresses to include.
+ * Addresses that appear more than once, even in different cases, are included only once.
+ * @param n_addresses The number of addresses at @p addresses.
+ * @param flags A bitwise combination of #bech32_address_set_flags.
+ * @param[out] bad A pointer to a variable that is to receive the index of the offending address if an address is invalid.
+ * @return The size of the built file, or a negative number if an error occurred, which may be any of the errors returned by
+ * bech32_address_decode() or blech32_address_decode(), or @c BECH32_BUFFER_INADEQUATE if memory could not be allocated.
+ */
+ssize_t bech32_address_set_build(
+		unsigned char **restrict out,
+		const char *const *restrict addresses,
+		size_t n_addresses,
+		unsigned flags,
+		size_t *restrict bad)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __access__ (write_only, 5), __nonnull__ (1, 5), __nothrow__, __warn_unused_result__));
 
-	explicit Decoder(std::string_view in) {
-		this->reset(in);
-	}
+/**
+ * @brief Opens a view of an address-set file in memory.
+ * @param[out] set A pointer to a view that is to be initialized.
+ * @param[in] data A pointer to the file, which must remain valid and unchanged for as long as the view is in use.
+ * @param n_data The size of the file at @p data.
+ * @return Zero if the view was opened, or -1 if the data are not a well-formed address-set file in a format that this library
+ * understands.
+ *
+ * The group descriptors and the bounds of all groups are validated, so queries on the view will not read outside of the file.
+ */
+int bech32_address_set_open(
+		struct bech32_address_set *restrict set,
+		const void *restrict data,
+		size_t n_data)
+	__attribute__ ((__access__ (write_only, 1), __access__ (read_only, 2, 3), __nonnull__, __nothrow__, __warn_unused_result__));
 
-public:
+/**
+ * @brief Tests whether an address is in an address-set file.
+ * @param[in] set A pointer to a view opened by bech32_address_set_open().
+ * @param[in] address A pointer to the address to look up.
+ * It may be in either the uppercase or lowercase form.
+ * @param n_address The size of the address at @p address, not including any null terminator that may be present but is not
+ * required.
+ * @return 1 if the address is in the set, 0 if it is not, or a negative number if the address is invalid, which may be any of
+ * the errors returned by bech32_address_decode() or blech32_address_decode().
+ */
+ssize_t bech32_address_set_contains(
+		const struct bech32_address_set *restrict set,
+		const char *restrict address,
+		size_t n_address)
+	__attribute__ ((__access__ (read_only, 1), __access__ (read_only, 2, 3), __nonnull__, __nothrow__, __pure__, __warn_unused_result__));
+
+#endif // !defined(BECH32_H_SECOND_PASS)
+
+
+#ifndef BECH32_H_SECOND_PASS
+
+/**
+ * @brief The kinds of invalid address that bech32_generate() can produce.
+ */
+enum bech32_generate_fault {
+	BECH32_GENERATE_VALID = 0, ///< the address is valid
+	BECH32_GENERATE_BAD_CHECKSUM = 1 << 0, ///< a data character is replaced by another, so the checksum fails
+	BECH32_GENERATE_MIXED_CASE = 1 << 1, ///< the case of a letter is flipped, so the address uses mixed case
+	BECH32_GENERATE_ILLEGAL_CHAR = 1 << 2, ///< a data character is replaced by one outside of the data alphabet
+};
+
+/**
+ * @brief Flags for bech32_generate().
+ */
+enum bech32_generate_flags {
+
+	/**
+	 * @brief Half of the addresses, chosen at random, are written in uppercase, as they are in QR codes.
+	 */
+	BECH32_GENERATE_UPPERCASE = 1 << 0,
+
+#ifndef DISABLE_BLECH32
+	/**
+	 * @brief The addresses are blinding addresses, encoded using Blech32/Blech32m.
+	 */
+	BECH32_GENERATE_BLECH32 = 1 << 1,
+#endif
+
+};
+
+/**
+ * @brief The mix of addresses that bech32_generate() is to produce.
+ */
+struct bech32_generate_params {
+	uint64_t seed; ///< the seed of the pseudorandom number generator
+	const char *const *hrps; ///< the null-terminated human-readable prefixes, one of which is chosen at random for each address
+	size_t n_hrps; ///< the number of prefixes at #hrps, which must not be zero
+	uint32_t versions; ///< a mask in which bit @c v is set iff witness version @c v may be chosen, or zero for versions 0 and 1
+	double invalid; ///< the probability, between 0 and 1, that an address is made invalid
+	unsigned faults; ///< a bitwise combination of the #bech32_generate_fault kinds to choose among, or zero for all of them
+	unsigned flags; ///< a bitwise combination of #bech32_generate_flags
+};
+
+/**
+ * @brief An address to be produced by bech32_generate().
+ */
+struct bech32_generate_item {
+	char *address; ///< a pointer to a buffer that is to receive the null-terminated address
+	size_t n_address; ///< the size of the buffer at #address
+	enum bech32_generate_fault fault; ///< receives the kind of fault with which the address was made invalid, if any
+	ssize_t ret; ///< receives the size of the address, or a negative number as returned by bech32_address_encode()
+};
+
+/**
+ * @brief Generates pseudorandom SegWit addresses for testing, in parallel if the batch is large.
+ * @param[in,out] items A pointer to an array of items, each of which is to receive an address.
+ * @param n_items The number of items at @p items.
+ * @param index The index of the address that the first item is to receive.
+ * @param[in] params A pointer to the parameters of the addresses to produce.
+ * @param[in] executor As for bech32_address_encode_batch().
+ *
+ * Each address is chosen at random from the human-readable prefixes and witness versions allowed by @p params. A version 0
+ * program is of the P2WPKH or P2WSH size, a version 1 program is of the P2TR size, and a program of any later version is
+ * of any legal size. Then, with the probability given by @p params, the address is made invalid by one of the allowed
+ * faults, which is recorded in the @c fault field of the item. Mixed case requires at least two letters in the address; an
+ * address with fewer is given another of the allowed faults instead or, if there is none, is left valid. An item whose
+ * parameters cannot be encoded, such as one given an illegal human-readable prefix or witness version, receives the error
+ * in its @c ret field.
+ *
+ * The address at a given index depends only on the index and on @p params, not on how the addresses are divided among
+ * batches or threads, so a corpus can be reproduced, extended, or generated in pieces.
+ */
+void bech32_generate(
+		struct bech32_generate_item *restrict items,
+		size_t n_items,
+		uint64_t index,
+		const struct bech32_generate_params *restrict params,
+		const struct bech32_executor *restrict executor)
+	__attribute__ ((__access__ (read_write, 1, 2), __access__ (read_only, 4), __access__ (read_only, 5), __nonnull__ (4), __nothrow__));
+
+#endif // !defined(BECH32_H_SECOND_PASS)
+
+
+#ifndef BECH32_H_SECOND_PASS
+ssize_t segwit_address_encode // line break so we don't generate man pages for these deprecated symbols
+	(char *restrict, size_t, const unsigned char *restrict, size_t, const char *restrict, size_t, unsigned)
+	__attribute__ ((__deprecated__ ("renamed to bech32_address_encode")));
+ssize_t segwit_address_decode // ditto
+	(unsigned char *restrict, size_t, const char *restrict, size_t, size_t *restrict, unsigned *restrict)
+	__attribute__ ((__deprecated__ ("renamed to bech32_address_decode")));
+#endif
+
+
+#ifdef __cplusplus
+} // extern "C"
+# undef restrict
+
+
+#ifndef BECH32_H_SECOND_PASS
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace bech32 {
+
+
+class Error : public std::runtime_error {
+
+public:
+	enum ::bech32_error error;
+
+public:
+	explicit Error(enum ::bech32_error error);
+
+};
+
+
+std::function<void (std::string_view)> ostream_sink(std::ostream &os);
+
+std::function<void (std::string_view)> fd_sink(int fd);
+
+
+/**
+ * @brief A view of a run of data characters within an encoding as the string of bits that they carry, five per character.
+ *
+ * The characters are not copied, and they are unpacked only when the bits are read. They must be valid data characters, as
+ * they are in the views that Decoder::read_span() and Decoder::fields() return.
+ */
+class BitSpan {
+
+private:
+	std::string_view in;
+
+public:
+	constexpr BitSpan() noexcept = default;
+
+	explicit constexpr BitSpan(std::string_view in) noexcept : in(in) { }
+
+public:
+	/**
+	 * @brief Returns the data characters spanned.
+	 */
+	constexpr std::string_view symbols() const noexcept {
+		return in;
+	}
+
+	/**
+	 * @brief Returns the number of bits spanned.
+	 */
+	constexpr size_t size() const noexcept {
+		return in.size() * 5;
+	}
+
+	constexpr bool empty() const noexcept {
+		return in.empty();
+	}
+
+	/**
+	 * @brief Returns the bits spanned as a big-endian unsigned integer.
+	 * @throw Error with @c BECH32_TOO_LONG if more than 64 bits are spanned.
+	 */
+	uint_least64_t value() const;
+
+	/**
+	 * @brief Unpacks the leading bits spanned, as Decoder::read() does.
+	 * @throw Error with @c BECH32_TOO_SHORT if fewer than @p nbits_out bits are spanned.
+	 */
+	void read(void *out, size_t nbits_out) const;
+
+	/**
+	 * @brief Unpacks the whole bytes spanned, discarding any trailing bits that do not fill a byte.
+	 */
+	std::vector<std::byte> bytes() const;
+
+};
+
+
+/**
+ * @brief A tagged field, as in the data part of a BOLT11 invoice: a 5-bit tag and a 10-bit length, followed by that many data
+ * characters.
+ */
+struct TaggedField {
+	unsigned tag;
+	size_t length; // in data characters
+	BitSpan data;
+};
+
+
+/**
+ * @brief A view of a sequence of tagged fields, which are parsed in place as they are iterated.
+ *
+ * The sequence is validated when Decoder::fields() returns it, so iteration does not fail.
+ */
+class TaggedFields : public std::ranges::view_interface<TaggedFields> {
+
+public:
+	class iterator {
+
+	private:
+		const char *p, *end;
+
+	public:
+		using iterator_concept = std::forward_iterator_tag;
+		// dereferencing yields a value rather than a reference, which a legacy forward iterator may not do
+		using iterator_category = std::input_iterator_tag;
+		using value_type = TaggedField;
+		using difference_type = std::ptrdiff_t;
+
+	public:
+		constexpr iterator() noexcept : p(), end() { }
+
+		constexpr iterator(const char *p, const char *end) noexcept : p(p), end(end) { }
+
+	public:
+		TaggedField operator*() const noexcept {
+			return TaggedFields::field(p);
+		}
+
+		iterator & operator++() noexcept {
+			p += 3/*header*/ + (**this).length;
+			return *this;
+		}
+
+		iterator operator++(int) noexcept {
+			iterator it = *this;
+			++*this;
+			return it;
+		}
+
+		bool operator==(const iterator &other) const noexcept {
+			return p == other.p;
+		}
+
+	};
+
+private:
+	std::string_view in;
+
+public:
+	constexpr TaggedFields() noexcept = default;
+
+	/**
+	 * @throw Error with @c BECH32_TOO_SHORT if the last field is truncated.
+	 */
+	explicit TaggedFields(std::string_view in);
+
+public:
+	/**
+	 * @brief Returns the data characters of all of the fields.
+	 */
+	constexpr std::string_view symbols() const noexcept {
+		return in;
+	}
+
+	iterator begin() const noexcept {
+		return { in.data(), in.data() + in.size() };
+	}
+
+	iterator end() const noexcept {
+		return { in.data() + in.size(), in.data() + in.size() };
+	}
+
+private:
+	static TaggedField field(const char *in) noexcept
+		__attribute__ ((__pure__));
+
+};
+
+
+} // namespace bech32
+
+#ifndef DISABLE_BLECH32
+namespace blech32 {
+using bech32::Error;
+using bech32::BitSpan;
+using bech32::TaggedField;
+using bech32::TaggedFields;
+} // namespace blech32
+#endif
+
+#endif // !defined(BECH32_H_SECOND_PASS)
+
+#ifdef INCLUDED_FOR_BLECH32
+#	define bech32 blech32
+#endif
+namespace bech32 {
+
+
+class Encoder {
+
+private:
+	struct ::bech32_encoder_state state;
+	std::string out;
+
+public:
+#if __cpp_lib_constexpr_string >= 201907L
+	constexpr
+#endif
+	Encoder() noexcept : state() { }
+
+	explicit Encoder(std::string_view hrp, size_t nbits_reserve = 0) {
+		this->reset(hrp, nbits_reserve);
+	}
+
+public:
+	void reset(std::string_view hrp, size_t nbits_reserve = 0);
+
+	void write(const void *in, size_t nbits_in);
+
+	std::string finish(bech32_constant_t constant = BECH32M_CONST);
+
+};
+
+
+using Sink = std::function<void (std::string_view)>;
+
+class StreamEncoder {
+
+public:
+	static constexpr size_t BLOCK_SIZE = 4096;
+
+private:
+	struct ::bech32_encoder_state state;
+	Sink sink;
+	std::array<char, BLOCK_SIZE> block;
+
+public:
+	explicit StreamEncoder(Sink sink) noexcept : state(), sink(std::move(sink)) { }
+
+	StreamEncoder(std::string_view hrp, Sink sink) : sink(std::move(sink)) {
+		this->reset(hrp);
+	}
+
+	// the encoder state points into the block, so an encoder cannot be copied or moved
+	StreamEncoder(const StreamEncoder &) = delete;
+	StreamEncoder & operator=(const StreamEncoder &) = delete;
+
+public:
+	void reset(std::string_view hrp);
+
+	void write(const void *in, size_t nbits_in);
+
+	void finish(bech32_constant_t constant = BECH32M_CONST);
+
+};
+
+
+class Decoder {
+
+private:
+	struct ::bech32_decoder_state state;
+	std::string_view hrp;
+
+public:
+	constexpr Decoder() noexcept : state() { }
+
+	/**
+	 * @param n_max The maximum size of the encoding, which may be @c SIZE_MAX to decode encodings of any size, such as BOLT11
+	 * invoices, whose checksums do not guarantee to detect errors as they do in encodings of up to @c BECH32_MAX_SIZE.
+	 */
+	explicit Decoder(std::string_view in, size_t n_max = BECH32_MAX_SIZE) {
+		this->reset(in, n_max);
+	}
+
+public:
 	std::string_view __attribute__ ((__pure__)) prefix() const noexcept {
 		return hrp;
 	}
@@ -506,6 +1370,8 @@ public:
 
 	void reset(std::string_view in);
 
+	void reset(std::string_view in, size_t n_max);
+
 	void read(void *out, size_t nbits_out);
 
 	std::vector<std::byte> read(size_t nbits);
@@ -514,8 +1380,206 @@ public:
 		return this->read(this->bits_remaining() & ~static_cast<size_t>(CHAR_BIT - 1));
 	}
 
+	/**
+	 * @brief Consumes enough whole data characters to carry @p nbits bits and returns a view of them in place.
+	 * @throw Error with @c BECH32_PADDING_ERROR if a previous read ended partway through a character or with
+	 * @c BECH32_TOO_SHORT if too few characters remain.
+	 */
+	BitSpan read_span(size_t nbits);
+
+	/**
+	 * @brief Consumes the tagged fields that precede a trailer of @p nbits_trailer bits and returns a view of them in place.
+	 *
+	 * A BOLT11 invoice, for example, has its fields between a 35-bit timestamp and a 520-bit signature.
+	 * @throw Error with @c BECH32_PADDING_ERROR if a previous read ended partway through a character or with
+	 * @c BECH32_TOO_SHORT if too few characters remain or the last field is truncated.
+	 */
+	TaggedFields fields(size_t nbits_trailer = 0);
+
 	size_t finish(bech32_constant_t constant = BECH32M_CONST);
 
+	size_t finish_detect(bech32_constant_t &constant);
+
+};
+
+
+class StreamDecoder {
+
+private:
+	struct ::bech32_stream_decoder_state state;
+
+public:
+	explicit StreamDecoder(size_t n_max = BECH32_MAX_SIZE) noexcept {
+		this->reset(n_max);
+	}
+
+public:
+	std::string_view __attribute__ ((__pure__)) prefix() const noexcept {
+		return { state.buf, state.n_hrp };
+	}
+
+	void reset(size_t n_max = BECH32_MAX_SIZE) noexcept {
+		::bech32_stream_decode_begin(&state, n_max);
+	}
+
+	std::vector<std::byte> write(std::string_view in);
+
+	std::vector<std::byte> finish(bech32_constant_t constant = BECH32M_CONST);
+
+};
+
+
+/**
+ * @brief A set of SegWit addresses, such as a watch list, optimized for testing addresses for membership.
+ *
+ * The set is a hash table keyed by the checksum characters at the end of each address, which are already a near-uniform hash
+ * of the human-readable prefix, witness version, and witness program, so a probe needs neither to decode nor to hash the
+ * address. Only a probe whose checksum matches that of a member is decoded, and it is reported as a member only if its
+ * human-readable prefix (ignoring case), witness version, and witness program all match.
+ */
+class AddressSet {
+
+private:
+	struct Slot {
+		bech32_constant_t key;
+		uint_least32_t index; // one more than the index of the member in entries, or zero if the slot is empty
+	};
+
+	struct Entry {
+		size_t offset; // of the member's lowercase human-readable prefix, followed by its witness program, in data
+		uint_least16_t n_hrp;
+		uint_least8_t n_program, version;
+	};
+
+private:
+	std::vector<Slot> slots;
+	std::vector<Entry> entries;
+	std::vector<unsigned char> data;
+
+public:
+	AddressSet() noexcept = default;
+
+	explicit AddressSet(size_t n) {
+		this->reserve(n);
+	}
+
+public:
+	size_t __attribute__ ((__pure__)) size() const noexcept {
+		return entries.size();
+	}
+
+	bool __attribute__ ((__pure__)) empty() const noexcept {
+		return entries.empty();
+	}
+
+	/**
+	 * @brief Makes room for at least @p n members without rehashing.
+	 */
+	void reserve(size_t n);
+
+	void clear() noexcept;
+
+	/**
+	 * @brief Adds an address to the set.
+	 * @return @c true if the address was added or @c false if it was already a member.
+	 * @throw Error if the address is invalid.
+	 */
+	bool insert(std::string_view address);
+
+	/**
+	 * @brief Adds many addresses to the set.
+	 * @return The number of addresses that were added, not counting any that were already members.
+	 * @throw Error if any address is invalid, in which case the addresses preceding it will have been added.
+	 */
+	size_t insert(std::span<const std::string_view> addresses);
+
+	/**
+	 * @brief Tests whether an address is a member of the set.
+	 *
+	 * An invalid address is never a member.
+	 */
+	bool __attribute__ ((__pure__)) contains(std::string_view address) const noexcept;
+
+	/**
+	 * @brief Tests many addresses for membership in the set.
+	 * @param addresses The addresses to test.
+	 * @param[out] results A pointer to an array that is to receive the result of testing each address.
+	 * @return The number of addresses that are members.
+	 *
+	 * This is faster than testing each address in turn, as it overlaps the cache misses of successive probes.
+	 */
+	size_t contains(std::span<const std::string_view> addresses, bool results[]) const noexcept;
+
+};
+
+
+/**
+ * @brief A bounded cache of recently decoded SegWit addresses, which may be shared by concurrent threads.
+ *
+ * Like an AddressSet, the cache is indexed by the checksum characters at the end of each address, so a lookup neither
+ * decodes nor hashes the address. The cache is divided into shards, each guarded by its own reader-writer lock, so lookups in
+ * any shard proceed concurrently and contend only with insertions into the same shard. When a shard is full, an insertion
+ * replaces the entry that the shard's CLOCK hand reaches first without its having been hit since the hand last passed it.
+ */
+class DecodeCache {
+
+public:
+	static constexpr size_t SHARDS = 16;
+
+private:
+	struct Shard;
+
+private:
+	std::unique_ptr<Shard[]> shards;
+
+public:
+	/**
+	 * @param capacity The maximum number of addresses to cache, which is divided evenly among the shards and rounded up.
+	 */
+	explicit DecodeCache(size_t capacity);
+
+	/**
+	 * @brief Takes over the entries of another cache, leaving it empty with a capacity of zero, so that it decodes without
+	 * caching.
+	 */
+	DecodeCache(DecodeCache &&) noexcept;
+
+	DecodeCache & operator=(DecodeCache &&) noexcept;
+
+	~DecodeCache();
+
+public:
+	size_t __attribute__ ((__pure__)) capacity() const noexcept;
+
+	/**
+	 * @brief Returns the number of addresses in the cache. The count may be stale if other threads are inserting concurrently.
+	 */
+	size_t size() const noexcept;
+
+	/**
+	 * @brief Returns the number of calls to decode() that found their addresses in the cache.
+	 */
+	uint_least64_t hits() const noexcept;
+
+	/**
+	 * @brief Returns the number of calls to decode() that did not find their addresses in the cache.
+	 */
+	uint_least64_t misses() const noexcept;
+
+	/**
+	 * @brief Empties the cache and zeroes its counters.
+	 */
+	void clear() noexcept;
+
+	/**
+	 * @brief Decodes an address as decode_segwit_address() does, consulting the cache first.
+	 * @throw Error if the address is invalid. Invalid addresses are never cached.
+	 *
+	 * The returned human-readable prefix views the given address, not the cache, so it remains valid however the cache
+	 * changes.
+	 */
+	std::tuple<std::vector<std::byte>, std::string_view, unsigned> decode(std::string_view address);
+
 };
 
 
@@ -530,6 +1594,278 @@ std::tuple<std::vector<std::byte>, std::string_view, unsigned> decode_segwit_add
 		std::string_view address)
 	__attribute__ ((__pure__));
 
+#ifndef INCLUDED_FOR_BLECH32
+
+/**
+ * @brief Encodes and decodes addresses whose witness programs are of a size fixed at compile time.
+ * @tparam ProgramSize The size of the witness program: 20 for P2WPKH or 32 for P2WSH and P2TR.
+ *
+ * These are faster than encode_segwit_address() and decode_segwit_address(), and decoding does not allocate.
+ */
+template <size_t ProgramSize>
+struct FixedAddress {
+
+	static_assert(ProgramSize == 20 || ProgramSize == 32, "only 20- and 32-byte programs are supported");
+
+	using program_t = std::array<std::byte, ProgramSize>;
+
+	static std::string encode(
+			const program_t &program,
+			std::string_view hrp,
+			unsigned version)
+		__attribute__ ((__pure__));
+
+	/**
+	 * @throw Error with @c SEGWIT_PROGRAM_ILLEGAL_SIZE if the address is valid but encodes a witness program of another size.
+	 */
+	static std::tuple<program_t, std::string_view, unsigned> decode(
+			std::string_view address)
+		__attribute__ ((__pure__));
+
+};
+
+extern template struct FixedAddress<20>;
+extern template struct FixedAddress<32>;
+
+#endif // !defined(INCLUDED_FOR_BLECH32)
+
+
+namespace views {
+
+
+/**
+ * @brief A view of the bytes that an encoding decodes to, which are decoded as they are iterated.
+ *
+ * The encoding is validated when the view is constructed, but its checksum is verified only when iteration reaches the end,
+ * whereupon any error is thrown from the increment, so the bytes are not authenticated until then. The view is an input
+ * range, which can be iterated only once and must not be moved while it is being iterated.
+ */
+class decode_view : public std::ranges::view_interface<decode_view> {
+
+public:
+	class iterator {
+
+	private:
+		decode_view *view;
+
+	public:
+		using iterator_concept = std::input_iterator_tag;
+		using value_type = std::byte;
+		using difference_type = std::ptrdiff_t;
+
+	public:
+		constexpr iterator() noexcept : view() { }
+
+		explicit constexpr iterator(decode_view *view) noexcept : view(view) { }
+
+	public:
+		std::byte operator*() const noexcept {
+			return view->byte;
+		}
+
+		iterator & operator++() {
+			view->next();
+			return *this;
+		}
+
+		void operator++(int) {
+			++*this;
+		}
+
+		bool operator==(std::default_sentinel_t) const noexcept {
+			return view->done;
+		}
+
+	};
+
+private:
+	Decoder decoder;
+	bech32_constant_t constant;
+	std::byte byte;
+	bool done;
+
+public:
+	constexpr decode_view() noexcept : constant(), byte(), done(true) { }
+
+	explicit decode_view(std::string_view in, bech32_constant_t constant = BECH32M_CONST) :
+			decoder(in), constant(constant), byte(), done(false) { }
+
+public:
+	std::string_view __attribute__ ((__pure__)) prefix() const noexcept {
+		return decoder.prefix();
+	}
+
+	iterator begin() {
+		if (!done)
+			this->next();
+		return iterator(this);
+	}
+
+	std::default_sentinel_t end() const noexcept {
+		return std::default_sentinel;
+	}
+
+private:
+	void next() {
+		if (decoder.bits_remaining() >= CHAR_BIT)
+			decoder.read(&byte, CHAR_BIT);
+		else
+			done = true, decoder.finish(constant);
+	}
+
+};
+
+
+/**
+ * @brief A view of the encoding of a range of bytes, whose characters are encoded as they are iterated.
+ * @tparam V The view of the bytes to encode.
+ *
+ * The human-readable prefix is validated when the view is constructed. The bytes are consumed from the underlying view only
+ * as far ahead as fills a buffer of @c BECH32_MAX_SIZE characters, and the checksum follows once they run out. The view is an
+ * input range, which can be iterated only once and must not be moved while it is being iterated.
+ */
+template <std::ranges::view V>
+	requires std::ranges::input_range<V> && requires (std::ranges::range_reference_t<V> b) { static_cast<unsigned char>(b); }
+class encode_view : public std::ranges::view_interface<encode_view<V>> {
+
+public:
+	class iterator {
+
+	private:
+		encode_view *view;
+
+	public:
+		using iterator_concept = std::input_iterator_tag;
+		using value_type = char;
+		using difference_type = std::ptrdiff_t;
+
+	public:
+		constexpr iterator() noexcept : view() { }
+
+		explicit constexpr iterator(encode_view *view) noexcept : view(view) { }
+
+	public:
+		char operator*() const noexcept {
+			return *view->pos;
+		}
+
+		iterator & operator++() {
+			if (++view->pos == view->state.out)
+				view->fill();
+			return *this;
+		}
+
+		void operator++(int) {
+			++*this;
+		}
+
+		bool operator==(std::default_sentinel_t) const noexcept {
+			return view->pos == view->state.out;
+		}
+
+	};
+
+private:
+	V base;
+	std::optional<std::ranges::iterator_t<V>> it; // engaged once iteration begins, as input iterators need not be default-constructible
+	struct ::bech32_encoder_state state;
+	const char *pos;
+	size_t n_prefix;
+	bech32_constant_t constant;
+	bool done;
+	std::array<char, BECH32_MAX_SIZE> buf;
+
+public:
+	encode_view() requires std::default_initializable<V> : base(), it(), state(), pos(), n_prefix(), constant(), done(true), buf() { }
+
+	encode_view(std::string_view hrp, V base, bech32_constant_t constant = BECH32M_CONST) :
+			base(std::move(base)), it(), pos(), n_prefix(hrp.size() + 1/*separator*/), constant(constant), done(false) {
+		if (auto error = ::bech32_encode_begin(&state, buf.data(), buf.size(), hrp.data(), hrp.size()))
+			throw Error(error);
+	}
+
+public:
+	iterator begin() noexcept(noexcept(std::ranges::begin(base))) {
+		// the view may have been moved since the prefix was written, so the encoder is pointed at this view's own buffer
+		pos = buf.data(), state.out = buf.data() + n_prefix, state.n_out = buf.size() - n_prefix;
+		it.emplace(std::ranges::begin(base));
+		return iterator(this);
+	}
+
+	std::default_sentinel_t end() const noexcept {
+		return std::default_sentinel;
+	}
+
+private:
+	void fill() {
+		pos = state.out = buf.data(), state.n_out = buf.size();
+		auto &it = *this->it;
+		auto end = std::ranges::end(base);
+		// consume whole bytes for as long as the buffer has room for the characters they complete
+		for (; it != end && state.n_out * 5 >= state.nbits + CHAR_BIT; ++it) {
+			auto byte = static_cast<unsigned char>(*it);
+			if (auto error = ::bech32_encode_data(&state, &byte, CHAR_BIT))
+				throw Error(error);
+		}
+		if (!done && it == end && state.n_out >= 1/*padding*/ + BECH32_CHECKSUM_SIZE) {
+			done = true;
+			if (auto error = ::bech32_encode_finish(&state, constant))
+				throw Error(error);
+		}
+	}
+
+};
+
+template <typename R>
+encode_view(std::string_view, R &&) -> encode_view<std::views::all_t<R>>;
+
+template <typename R>
+encode_view(std::string_view, R &&, bech32_constant_t) -> encode_view<std::views::all_t<R>>;
+
+
+/**
+ * @brief The range adaptor returned by encode(std::string_view, bech32_constant_t).
+ */
+struct encode_adaptor {
+
+	std::string_view hrp;
+	bech32_constant_t constant;
+
+	template <std::ranges::viewable_range R>
+	friend auto operator|(R &&range, const encode_adaptor &adaptor) {
+		return encode_view(adaptor.hrp, std::views::all(std::forward<R>(range)), adaptor.constant);
+	}
+
+};
+
+
+/**
+ * @brief Returns a lazy view of the bytes that an encoding decodes to.
+ * @see decode_view
+ */
+inline decode_view decode(std::string_view in, bech32_constant_t constant = BECH32M_CONST) {
+	return decode_view(in, constant);
+}
+
+/**
+ * @brief Returns a lazy view of the encoding of a range of bytes.
+ * @see encode_view
+ */
+template <std::ranges::viewable_range R>
+inline auto encode(std::string_view hrp, R &&range, bech32_constant_t constant = BECH32M_CONST) {
+	return encode_view(hrp, std::views::all(std::forward<R>(range)), constant);
+}
+
+/**
+ * @brief Returns a range adaptor that encodes the range piped into it, as in <tt>bytes | views::encode(hrp)</tt>.
+ */
+constexpr encode_adaptor encode(std::string_view hrp, bech32_constant_t constant = BECH32M_CONST) noexcept {
+	return { hrp, constant };
+}
+
+
+} // namespace views
+
 
 } // namespace bech32
 #undef bech32
@@ -538,4 +1874,8 @@ std::tuple<std::vector<std::byte>, std::string_view, unsigned> decode_segwit_add
 
 #undef BECH32_H_SECOND_PASS
 
+#if defined(BECH32_HEADER_ONLY) && !defined(INCLUDED_FOR_BLECH32)
+#	include "bech32_impl.h"
+#endif
+
 #endif // !defined(BECH32_H_INCLUDED)
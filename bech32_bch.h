@@ -0,0 +1,1040 @@
+/// @file
+#ifndef BECH32_BCH_H_INCLUDED
+#define BECH32_BCH_H_INCLUDED
+
+#ifndef __cplusplus
+#	error "bech32_bch.h requires a C++ compiler"
+#endif
+
+#include "bech32.h"
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <string.h>
+
+#define BECH32_LIKELY(...) __builtin_expect(!!(__VA_ARGS__), 1)
+#define BECH32_UNLIKELY(...) __builtin_expect(!!(__VA_ARGS__), 0)
+
+
+namespace bech32 {
+
+/**
+ * @brief Generic engine for BCH checksummed base-32 encodings.
+ *
+ * The Bech32/Bech32m/Blech32/Blech32m codecs exported by the C API are instantiations of the templates in this namespace.
+ * Other codes (e.g., with different generators, checksum lengths, or size limits) may be defined by instantiating #Code with
+ * different parameters.
+ */
+namespace bch __attribute__ ((__visibility__ ("hidden"))) {
+
+
+inline constexpr char ENCODE[32] = {
+	'q', 'p', 'z', 'r', 'y', '9', 'x', '8', 'g', 'f', '2', 't', 'v', 'd', 'w', '0',
+	's', '3', 'j', 'n', '5', '4', 'k', 'h', 'c', 'e', '6', 'm', 'u', 'a', '7', 'l'
+};
+
+inline constexpr int8_t DECODE['z' - '0' + 1] = {
+	15, -1, 10, 17, 21, 20, 26, 30,  7,  5, -1, -1, -1, -1, -1, -1,
+	-1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+	 1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2, -1, -1, -1, -1, -1,
+	-1, 29, -1, 24, 13, 25,  9,  8, 23, -1, 18, 22, 31, 27, 19, -1,
+	 1,  0,  3, 16, 11, 28, 12, 14,  6,  4,  2
+};
+
+// DECODE extended to every byte value, with flags for the case of each letter and for illegal characters, so that a single
+// lookup validates a character of a data part and no range check is needed
+enum : uint8_t { DECODE_LOWER = 0x20, DECODE_UPPER = 0x40, DECODE_ILLEGAL = 0x80 };
+inline constexpr std::array<uint8_t, 256> DECODE_FLAGS = [] {
+	std::array<uint8_t, 256> table;
+	table.fill(DECODE_ILLEGAL);
+	for (unsigned c = '0'; c <= 'z'; ++c)
+		if (DECODE[c - '0'] >= 0)
+			table[c] = static_cast<uint8_t>(DECODE[c - '0'] | (c >= 'a' ? DECODE_LOWER : c >= 'A' ? DECODE_UPPER : 0));
+	return table;
+}();
+
+// No data-dependent branches! Assumes string contains only character codes 0-127.
+inline constexpr bool __attribute__ ((__pure__)) is_mixed_case(const char *in, size_t n_in) noexcept {
+#if SIZE_MAX >= UINT64_MAX || defined(__x86_64__/*support x32*/)
+	uint_fast64_t flags = 0;
+	for (size_t i = 0; i < n_in; ++i)
+		flags |= static_cast<uint_fast64_t>(1) << (in[i] - 1 >> 1 & 0x3F);
+	return (flags & UINT64_C(0x1FFF00000000)) && (flags & UINT64_C(0x1FFF000000000000));
+#else
+	uint_fast32_t flags = 0;
+	for (size_t i = 0; i < n_in; ++i)
+		flags |= static_cast<uint_fast32_t>(in[i]) >> 6 << (in[i] - 1 >> 1 & 0x1F);
+	return (flags & 0x1FFF) && (flags & UINT32_C(0x1FFF0000));
+#endif
+}
+
+
+/**
+ * @brief A BCH code over GF(32) used as the checksum of a base-32 encoding.
+ * @tparam Checksum An unsigned integer type wide enough to hold `5 * ChecksumSize` bits.
+ * @tparam ChecksumSize The number of characters in the checksum.
+ * @tparam MaxSize The maximum size of an encoding in characters.
+ * @tparam Generators The five generator constants of the code.
+ *
+ * The static member functions of this class implement the operations of the low-level C API on any state structure having
+ * the same members as @c bech32_encoder_state or @c bech32_decoder_state.
+ */
+template <typename Checksum, size_t ChecksumSize, size_t MaxSize, Checksum... Generators>
+struct Code {
+
+	static_assert(sizeof...(Generators) == 5, "a BCH code over GF(32) has five generators");
+	static_assert(ChecksumSize * 5 <= sizeof(Checksum) * CHAR_BIT, "checksum type is too narrow");
+
+	using checksum_t = Checksum;
+
+	static constexpr size_t
+		CHECKSUM_SIZE = ChecksumSize,
+		HRP_MIN_SIZE = 1,
+		MAX_SIZE = MaxSize,
+		HRP_MAX_SIZE = MAX_SIZE - 1/*separator*/ - CHECKSUM_SIZE,
+		MIN_SIZE = HRP_MIN_SIZE + 1/*separator*/ + CHECKSUM_SIZE;
+
+private:
+	static constexpr unsigned SHIFT = CHECKSUM_SIZE * 5 - 5;
+	static constexpr checksum_t MASK = (static_cast<checksum_t>(1) << SHIFT) - 1;
+
+	using lut_t = std::conditional_t<CHECKSUM_SIZE * 5 <= 32, uint_least32_t, uint_least64_t>;
+	static constexpr std::array<lut_t, 32> LUT = [] {
+		constexpr checksum_t generators[] = { Generators... };
+		std::array<lut_t, 32> lut { };
+		for (unsigned i = 0; i < 32; ++i)
+			for (unsigned j = 0; j < 5; ++j)
+				if (i & 1 << j)
+					lut[i] ^= static_cast<lut_t>(generators[j]);
+		return lut;
+	}();
+
+	// POWERS<N>[i][v] is the result of applying polymod N times to v shifted into the i-th 5-bit group of a checksum.
+	template <size_t N>
+	static constexpr std::array<std::array<lut_t, 32>, CHECKSUM_SIZE> POWERS = [] {
+		std::array<std::array<lut_t, 32>, CHECKSUM_SIZE> powers { };
+		for (unsigned i = 0; i < CHECKSUM_SIZE; ++i)
+			for (unsigned v = 0; v < 32; ++v) {
+				checksum_t chk = static_cast<checksum_t>(v) << 5 * i;
+				for (size_t n = 0; n < N; ++n)
+					chk = (chk & MASK) << 5 ^ LUT[chk >> SHIFT];
+				powers[i][v] = static_cast<lut_t>(chk);
+			}
+		return powers;
+	}();
+
+public:
+	static inline constexpr checksum_t __attribute__ ((__const__)) polymod(checksum_t chk) noexcept {
+		return (chk & MASK) << 5 ^ LUT[chk >> SHIFT];
+	}
+
+	/**
+	 * @brief Applies polymod N times with no input, as if N zeros followed, in independent table lookups rather than a chain.
+	 *
+	 * Since the code is linear, this allows the checksums of separate segments of an input to be computed independently and
+	 * then combined.
+	 */
+	template <size_t N>
+	static inline constexpr checksum_t __attribute__ ((__const__)) polymod_n(checksum_t chk) noexcept {
+		if constexpr (N == 0)
+			return chk;
+		else {
+			checksum_t ret = 0;
+			for (unsigned i = 0; i < CHECKSUM_SIZE; ++i)
+				ret ^= POWERS<N>[i][chk >> 5 * i & 0x1F];
+			return ret;
+		}
+	}
+
+	static inline constexpr checksum_t __attribute__ ((__pure__)) polymod_hrp(checksum_t chk, const char *hrp, size_t n_hrp) noexcept {
+		for (size_t i = 0; i < n_hrp; ++i)
+			chk = polymod(chk) ^ (hrp[i] >> 5 | (hrp[i] >= 'A' && hrp[i] <= 'Z'));
+		chk = polymod(chk);
+		for (size_t i = 0; i < n_hrp; ++i)
+			chk = polymod(chk) ^ hrp[i] & 0x1F;
+		return chk;
+	}
+
+	/**
+	 * @brief Accumulates the checksum of a human-readable prefix a character at a time, before its length is known.
+	 *
+	 * The high and low bits of the characters are accumulated in two separate registers, which #finish combines once the
+	 * length is known, since the code is linear. Illegal characters and the cases of letters are noted rather than rejected,
+	 * so that the caller can check them once at the end.
+	 */
+	struct HrpAccumulator {
+		checksum_t hi = 1, lo = 0;
+		unsigned cases = 0; // bit 0 if any letter is lowercase, bit 1 if any is uppercase
+		bool illegal = false;
+
+		inline void update(char c) noexcept {
+			// the high bits of a non-ASCII byte must not sign-extend into the checksum
+			auto u = static_cast<unsigned char>(c);
+			illegal |= u < 0x21 || u >= 0x7F;
+			unsigned upper = u >= 'A' && u <= 'Z';
+			cases |= (u >= 'a' && u <= 'z') | upper << 1;
+			hi = polymod(hi) ^ (u >> 5 | upper), lo = polymod(lo) ^ (u & 0x1F);
+		}
+
+		inline checksum_t __attribute__ ((__pure__)) finish(size_t n_hrp) const noexcept {
+			checksum_t chk = hi;
+			for (size_t i = 0; i <= n_hrp; ++i)
+				chk = polymod(chk);
+			return chk ^ lo;
+		}
+	};
+
+	static inline constexpr size_t __attribute__ ((__const__)) encoded_size(size_t n_hrp, size_t nbits_in, size_t n_pad) noexcept {
+		size_t n_out;
+		if (BECH32_UNLIKELY(__builtin_add_overflow(nbits_in, 4, &nbits_in) ||
+				__builtin_add_overflow(n_hrp, 1/*separator*/ + nbits_in / 5 + CHECKSUM_SIZE, &n_out) ||
+				__builtin_add_overflow(n_out, n_pad, &n_out)))
+			return SIZE_MAX;
+		return n_out;
+	}
+
+private:
+	template <typename State>
+	static inline void encode(State *__restrict state) noexcept {
+		while (state->nbits >= 5) {
+			checksum_t v = state->bits >> (state->nbits -= 5) & 0x1F;
+			state->chk = polymod(state->chk) ^ v;
+			*state->out++ = ENCODE[v], --state->n_out;
+		}
+	}
+
+public:
+	template <typename State>
+	static inline enum bech32_error encode_begin(State *__restrict state, char *__restrict out, size_t n_out, const char *__restrict hrp, size_t n_hrp) noexcept {
+		if (BECH32_UNLIKELY(n_hrp < HRP_MIN_SIZE))
+			return BECH32_HRP_TOO_SHORT;
+		if (BECH32_UNLIKELY(n_hrp > HRP_MAX_SIZE))
+			return BECH32_HRP_TOO_LONG;
+		for (size_t i = 0; i < n_hrp; ++i)
+			if (BECH32_UNLIKELY(hrp[i] < 0x21 || hrp[i] >= 0x7F))
+				return BECH32_HRP_ILLEGAL_CHAR;
+		if (BECH32_UNLIKELY(__builtin_sub_overflow(n_out, n_hrp, &n_out) || n_out < 1/*separator*/ + CHECKSUM_SIZE))
+			return BECH32_BUFFER_INADEQUATE;
+		for (size_t i = 0; i < n_hrp; ++i)
+			out[i] = static_cast<char>(hrp[i] | (hrp[i] >= 'A' && hrp[i] <= 'Z' ? 0x20 : 0));
+		out += n_hrp;
+		*out++ = '1', --n_out;
+		state->out = out, state->n_out = n_out;
+		state->nbits = 0, state->bits = 0;
+		state->chk = polymod_hrp(1, hrp, n_hrp);
+		return static_cast<enum bech32_error>(0);
+	}
+
+	template <typename State>
+	static inline enum bech32_error encode_data(State *__restrict state, const unsigned char *__restrict in, size_t nbits_in) noexcept {
+		size_t nbits;
+		if (BECH32_UNLIKELY(__builtin_add_overflow(state->nbits, nbits_in, &nbits) || state->n_out < nbits / 5))
+			return BECH32_BUFFER_INADEQUATE;
+		for (size_t i = 0;;) {
+			encode(state);
+			if (nbits_in >= CHAR_BIT)
+				state->bits = state->bits << CHAR_BIT | in[i++], state->nbits += CHAR_BIT, nbits_in -= CHAR_BIT;
+			else if (nbits_in)
+				state->bits = state->bits << nbits_in | in[i++], state->nbits += nbits_in, nbits_in = 0;
+			else
+				return static_cast<enum bech32_error>(0);
+		}
+	}
+
+	template <typename State>
+	static inline enum bech32_error encode_finish(State *__restrict state, checksum_t constant) noexcept {
+		if (BECH32_UNLIKELY(state->n_out < !!state->nbits + CHECKSUM_SIZE))
+			return BECH32_BUFFER_INADEQUATE;
+		if (state->nbits) {
+			state->bits <<= 5 - state->nbits, state->nbits = 5;
+			encode(state);
+		}
+		state->bits = state->chk;
+		for (size_t i = 0; i < CHECKSUM_SIZE; ++i)
+			state->bits = polymod(state->bits);
+		state->bits ^= constant, state->nbits = CHECKSUM_SIZE * 5;
+		encode(state);
+		if (BECH32_UNLIKELY(state->chk != constant))
+			return BECH32_CHECKSUM_FAILURE;
+		return static_cast<enum bech32_error>(0);
+	}
+
+private:
+	// The checksum of a long run of characters is computed in interleaved lanes, each over a segment of this many characters,
+	// which are then shifted into place by polymod_n. This breaks the single chain of dependent polymod steps into
+	// independent chains that the processor can execute in parallel.
+	static constexpr size_t SEGMENT_SIZE = 16, SEGMENT_LANES = 4;
+
+public:
+	/**
+	 * @brief The number of data characters at or above which their checksum is computed in segments rather than in one chain.
+	 *
+	 * Measured to break even at one full block of segments.
+	 */
+	static constexpr size_t SEGMENTED_MIN_SIZE = SEGMENT_SIZE * SEGMENT_LANES;
+
+private:
+
+	static inline checksum_t __attribute__ ((__pure__)) polymod_segmented(checksum_t chk, const char *__restrict in, size_t n_in) noexcept {
+		for (; n_in >= SEGMENT_SIZE * SEGMENT_LANES; in += SEGMENT_SIZE * SEGMENT_LANES, n_in -= SEGMENT_SIZE * SEGMENT_LANES) {
+			checksum_t lanes[SEGMENT_LANES] = { };
+#pragma GCC unroll 16
+			for (size_t i = 0; i < SEGMENT_SIZE; ++i)
+#pragma GCC unroll 8
+				for (size_t j = 0; j < SEGMENT_LANES; ++j)
+					lanes[j] = polymod(lanes[j]) ^ (DECODE_FLAGS[static_cast<unsigned char>(in[j * SEGMENT_SIZE + i])] & 0x1F);
+			for (size_t j = 0; j < SEGMENT_LANES; ++j)
+				chk = polymod_n<SEGMENT_SIZE>(chk) ^ lanes[j];
+		}
+		for (; n_in; --n_in)
+			chk = polymod(chk) ^ (DECODE_FLAGS[static_cast<unsigned char>(*in++)] & 0x1F);
+		return chk;
+	}
+
+	template <typename State>
+	static inline bool decode(State *__restrict state, size_t nbits) noexcept {
+		while (state->nbits < nbits) {
+			int_fast32_t v = static_cast<int_fast32_t>(*state->in++) - '0'; --state->n_in;
+			if (BECH32_UNLIKELY(v < 0 || v > 'z' - '0' || (v = DECODE[v]) < 0))
+				return false;
+			state->chk = polymod(state->chk) ^ v;
+			state->bits = state->bits << 5 | v, state->nbits += 5;
+		}
+		return true;
+	}
+
+	template <typename State>
+	static inline enum bech32_error decode_bits(State *__restrict state, unsigned char *out, size_t nbits_out) noexcept {
+		for (size_t i = 0;;)
+			if (BECH32_UNLIKELY(!decode(state, nbits_out > CHAR_BIT ? CHAR_BIT : nbits_out)))
+				return BECH32_ILLEGAL_CHAR;
+			else if (nbits_out >= CHAR_BIT)
+				out[i++] = static_cast<unsigned char>(state->bits >> state->nbits - CHAR_BIT), state->nbits -= CHAR_BIT, nbits_out -= CHAR_BIT;
+			else if (nbits_out)
+				out[i++] = static_cast<unsigned char>(state->bits >> state->nbits - nbits_out & (1 << nbits_out) - 1), state->nbits -= nbits_out, nbits_out = 0;
+			else
+				return static_cast<enum bech32_error>(0);
+	}
+
+	// Unpacks a run of characters whose checksum has been computed separately, eight characters to five bytes at a time.
+	// Rather than branching on the legality of each character, it notes any illegal character and returns false at the end,
+	// in which case the state and the output are indeterminate. Requires fewer than eight bits to be pending in the state.
+	template <typename State>
+	static inline bool unpack(State *__restrict state, unsigned char *out, size_t nbits_out) noexcept {
+		const char *in = state->in;
+		uint_fast64_t bits = state->bits;
+		size_t nbits = state->nbits;
+		unsigned flags = 0;
+		for (; nbits_out >= 5 * CHAR_BIT; nbits_out -= 5 * CHAR_BIT, in += 8, out += 5) {
+			uint_fast64_t group = 0;
+#pragma GCC unroll 8
+			for (unsigned i = 0; i < 8; ++i) {
+				uint_fast8_t v = DECODE_FLAGS[static_cast<unsigned char>(in[i])];
+				flags |= v, group = group << 5 | (v & 0x1F);
+			}
+			bits = bits << 5 * CHAR_BIT | group;
+#pragma GCC unroll 5
+			for (unsigned i = 0; i < 5; ++i)
+				out[i] = static_cast<unsigned char>(bits >> (nbits + CHAR_BIT * (4 - i)));
+		}
+		while (nbits_out) {
+			size_t n = nbits_out > CHAR_BIT ? CHAR_BIT : nbits_out;
+			for (; nbits < n; nbits += 5) {
+				uint_fast8_t v = DECODE_FLAGS[static_cast<unsigned char>(*in++)];
+				flags |= v, bits = bits << 5 | (v & 0x1F);
+			}
+			*out++ = static_cast<unsigned char>(bits >> (nbits -= n) & (1 << n) - 1), nbits_out -= n;
+		}
+		state->n_in -= in - state->in, state->in = in;
+		state->bits = static_cast<decltype(state->bits)>(bits), state->nbits = nbits;
+		return !(flags & DECODE_ILLEGAL);
+	}
+
+public:
+	/**
+	 * @param n_max The maximum size of the encoding, which may exceed @c MAX_SIZE for protocols, such as BOLT11, that use the
+	 * code to carry more data than its checksum was designed to protect.
+	 */
+	template <typename State>
+	static inline ssize_t decode_begin(State *__restrict state, const char *__restrict in, size_t n_in, size_t n_max = MAX_SIZE) noexcept {
+		if (BECH32_UNLIKELY(n_in < MIN_SIZE))
+			return BECH32_TOO_SHORT;
+		if (BECH32_UNLIKELY(n_in > n_max))
+			return BECH32_TOO_LONG;
+		auto sep = static_cast<const char *>(::memrchr(in, '1', n_in));
+		if (BECH32_UNLIKELY(!sep))
+			return BECH32_NO_SEPARATOR;
+		size_t n_hrp = sep - in;
+		if (BECH32_UNLIKELY(n_hrp < HRP_MIN_SIZE))
+			return BECH32_HRP_TOO_SHORT;
+		if (BECH32_UNLIKELY(n_hrp > HRP_MAX_SIZE))
+			return BECH32_HRP_TOO_LONG;
+		for (size_t i = 0; i < n_hrp; ++i)
+			if (BECH32_UNLIKELY(in[i] < 0x21 || in[i] >= 0x7F))
+				return BECH32_HRP_ILLEGAL_CHAR;
+		for (const char *p = in + n_hrp + 1/*separator*/, *end = in + n_in; p != end;) {
+			int_fast32_t v = static_cast<int_fast32_t>(*p++) - '0';
+			if (BECH32_UNLIKELY(v < 0 || v > 'z' - '0' || DECODE[v] < 0))
+				return BECH32_ILLEGAL_CHAR;
+		}
+		if (BECH32_UNLIKELY(is_mixed_case(in, n_in)))
+			return BECH32_MIXED_CASE;
+		if (BECH32_UNLIKELY(__builtin_sub_overflow(n_in, n_hrp + 1/*separator*/ + CHECKSUM_SIZE, &n_in)))
+			return BECH32_TOO_SHORT;
+		state->in = in + n_hrp + 1/*separator*/, state->n_in = n_in;
+		state->nbits = 0, state->bits = 0;
+		state->chk = polymod_hrp(1, in, n_hrp);
+		return n_hrp;
+	}
+
+	/**
+	 * @brief Validates an encoding and computes the residue of its checksum without unpacking its data.
+	 * @param[out] chk A pointer to a variable that is to receive the residue, which equals the constant of the variant that
+	 * produced the encoding if the encoding is intact.
+	 * @return The size of the human-readable prefix, or any of the errors returned by #decode_begin.
+	 */
+	static inline ssize_t residue(checksum_t *__restrict chk, const char *__restrict in, size_t n_in) noexcept {
+		struct {
+			const char *in;
+			size_t n_in, nbits;
+			checksum_t bits, chk;
+		} state;
+		ssize_t n_hrp = decode_begin(&state, in, n_in);
+		if (BECH32_UNLIKELY(n_hrp < 0))
+			return n_hrp;
+		size_t n_data = in + n_in - state.in;
+		checksum_t c = state.chk;
+		if (n_data >= SEGMENTED_MIN_SIZE)
+			c = polymod_segmented(c, state.in, n_data);
+		else
+			for (const char *p = state.in, *end = in + n_in; p != end; ++p)
+				c = polymod(c) ^ DECODE[*p - '0'];
+		*chk = c;
+		return n_hrp;
+	}
+
+	/**
+	 * @brief Unpacks data characters into bytes.
+	 *
+	 * The output may overlap the encoding, provided that it begins no later than the first character not yet consumed, since
+	 * each byte is then written only over characters that have already been consumed. Every character was validated by
+	 * #decode_begin, so the fallback to decoding one character at a time is never taken after the output has overwritten any.
+	 */
+	template <typename State>
+	static inline enum bech32_error decode_data(State *__restrict state, unsigned char *out, size_t nbits_out) noexcept {
+		size_t nbits;
+		if (BECH32_UNLIKELY(!__builtin_sub_overflow(nbits_out, state->nbits, &nbits) &&
+				(__builtin_add_overflow(nbits, 4, &nbits) || state->n_in < nbits / 5)))
+			return BECH32_BUFFER_INADEQUATE;
+		// the output may alias the state, so working on a copy keeps the state in registers
+		State local = *state;
+		// a long run of characters has its checksum computed in segments and is unpacked separately; if it contains an
+		// illegal character, then it is decoded again one character at a time so as to fail at exactly the same point
+		if (size_t n_chars = nbits_out > local.nbits ? (nbits_out - local.nbits + 4) / 5 : 0; n_chars >= SEGMENTED_MIN_SIZE && local.nbits < CHAR_BIT) {
+			checksum_t chk = polymod_segmented(local.chk, local.in, n_chars);
+			if (BECH32_LIKELY(unpack(&local, out, nbits_out))) {
+				local.chk = chk, *state = local;
+				return static_cast<enum bech32_error>(0);
+			}
+			local = *state;
+		}
+		enum bech32_error error = decode_bits(&local, out, nbits_out);
+		*state = local;
+		return error;
+	}
+
+	/**
+	 * @brief Consumes whole data characters without unpacking them, so that the caller may interpret them in place.
+	 * @return 0 if the characters were consumed, or a negative number if an error occurred, which may be
+	 * @c BECH32_PADDING_ERROR because bits of a partially consumed character remain in the state or
+	 * @c BECH32_TOO_SHORT because fewer than @p n_chars data characters remain.
+	 */
+	template <typename State>
+	static inline enum bech32_error decode_skip(State *__restrict state, size_t n_chars) noexcept {
+		if (BECH32_UNLIKELY(state->nbits))
+			return BECH32_PADDING_ERROR;
+		if (BECH32_UNLIKELY(state->n_in < n_chars))
+			return BECH32_TOO_SHORT;
+		// decode_begin has already rejected any illegal characters
+		state->chk = polymod_segmented(state->chk, state->in, n_chars);
+		state->in += n_chars, state->n_in -= n_chars;
+		return static_cast<enum bech32_error>(0);
+	}
+
+private:
+	// Consumes the checksum characters, leaving the residue in the state for the caller to compare.
+	template <typename State>
+	static inline ssize_t decode_checksum(State *__restrict state) noexcept {
+		ssize_t nbits_pad = state->nbits;
+		if (BECH32_UNLIKELY(state->n_in || nbits_pad && (state->bits & (1 << nbits_pad) - 1)))
+			return BECH32_PADDING_ERROR;
+		state->n_in = CHECKSUM_SIZE, state->nbits = 0;
+		if (BECH32_UNLIKELY(!decode(state, CHECKSUM_SIZE * 5)))
+			return BECH32_ILLEGAL_CHAR;
+		state->nbits = 0;
+		if (BECH32_UNLIKELY(state->n_in))
+			return BECH32_CHECKSUM_FAILURE;
+		return nbits_pad;
+	}
+
+public:
+	template <typename State>
+	static inline ssize_t decode_finish(State *__restrict state, checksum_t constant) noexcept {
+		ssize_t nbits_pad = decode_checksum(state);
+		if (BECH32_UNLIKELY(nbits_pad >= 0 && state->chk != constant))
+			return BECH32_CHECKSUM_FAILURE;
+		return nbits_pad;
+	}
+
+	/**
+	 * @brief Finishes a decoding as #decode_finish does but accepts any of the given constants.
+	 * @param[out] constant A pointer to a variable that is to receive whichever of @p constants the checksum matched.
+	 */
+	template <typename State, typename... Constants>
+	static inline ssize_t decode_finish_detect(State *__restrict state, checksum_t *__restrict constant, Constants... constants) noexcept {
+		ssize_t nbits_pad = decode_checksum(state);
+		if (BECH32_LIKELY(nbits_pad >= 0) && !((state->chk == constants && (*constant = constants, true)) || ...))
+			return BECH32_CHECKSUM_FAILURE;
+		return nbits_pad;
+	}
+
+private:
+	// Resolving the separator only once more input arrives than fits in a maximum-size encoding preserves the precedence of
+	// BECH32_TOO_LONG over errors in the human-readable prefix.
+	static constexpr size_t STREAM_BUFFER_SIZE = MAX_SIZE;
+	static constexpr checksum_t TAIL_MASK = (static_cast<checksum_t>(1) << CHECKSUM_SIZE * 5) - 1;
+
+	// Feeds one data value into the checksum and the hold-back line, emitting any completed byte.
+	template <typename State>
+	static inline void stream_decode_value(State *__restrict state, checksum_t v, unsigned char *__restrict &out) noexcept {
+		state->chk = polymod(state->chk) ^ v;
+		if (state->n_tail < CHECKSUM_SIZE) {
+			state->tail = state->tail << 5 | v, ++state->n_tail;
+			return;
+		}
+		checksum_t d = state->tail >> SHIFT;
+		state->tail = (state->tail << 5 | v) & TAIL_MASK;
+		state->bits = state->bits << 5 | d, state->nbits += 5;
+		if (state->nbits >= CHAR_BIT)
+			*out++ = static_cast<unsigned char>(state->bits >> (state->nbits -= CHAR_BIT));
+	}
+
+	template <typename State>
+	static inline enum bech32_error stream_decode_char(State *__restrict state, char c, unsigned char *__restrict &out) noexcept {
+		int_fast32_t v = static_cast<int_fast32_t>(c) - '0';
+		if (BECH32_UNLIKELY(v < 0 || v > 'z' - '0' || (v = DECODE[v]) < 0))
+			return c == '1' ? BECH32_HRP_TOO_LONG : BECH32_ILLEGAL_CHAR;
+		state->cases |= (c >= 'a') | (c >= 'A' && c <= 'Z') << 1;
+		stream_decode_value(state, v, out);
+		return static_cast<enum bech32_error>(0);
+	}
+
+	// Locates the separator among the buffered leading characters and decodes any data characters that follow it.
+	template <typename State>
+	static inline enum bech32_error stream_decode_resolve(State *__restrict state, unsigned char *__restrict &out) noexcept {
+		auto sep = static_cast<const char *>(::memrchr(state->buf, '1', state->n_buf));
+		if (BECH32_UNLIKELY(!sep))
+			return BECH32_NO_SEPARATOR;
+		size_t n_hrp = sep - state->buf;
+		if (BECH32_UNLIKELY(n_hrp < HRP_MIN_SIZE))
+			return BECH32_HRP_TOO_SHORT;
+		if (BECH32_UNLIKELY(n_hrp > HRP_MAX_SIZE))
+			return BECH32_HRP_TOO_LONG;
+		for (size_t i = 0; i < n_hrp; ++i)
+			if (BECH32_UNLIKELY(state->buf[i] < 0x21 || state->buf[i] >= 0x7F))
+				return BECH32_HRP_ILLEGAL_CHAR;
+			else
+				state->cases |= (state->buf[i] >= 'a' && state->buf[i] <= 'z') | (state->buf[i] >= 'A' && state->buf[i] <= 'Z') << 1;
+		state->chk = polymod_hrp(1, state->buf, n_hrp);
+		enum bech32_error error;
+		for (size_t i = n_hrp + 1/*separator*/; i < state->n_buf; ++i)
+			if (BECH32_UNLIKELY((error = stream_decode_char(state, state->buf[i], out)) < 0))
+				return error;
+		state->n_hrp = state->n_buf = n_hrp;
+		return static_cast<enum bech32_error>(0);
+	}
+
+public:
+	template <typename State>
+	static inline void stream_decode_begin(State *__restrict state, size_t n_max) noexcept {
+		static_assert(sizeof state->buf == STREAM_BUFFER_SIZE);
+		state->n_in = 0, state->n_max = n_max;
+		state->n_hrp = 0, state->n_buf = 0, state->n_tail = 0;
+		state->nbits = 0, state->bits = 0, state->tail = 0;
+		state->cases = 0;
+	}
+
+	template <typename State>
+	static inline constexpr size_t __attribute__ ((__pure__)) stream_decoded_size(const State *__restrict state, size_t n_in) noexcept {
+		return ((state->n_hrp ? 0 : state->n_buf) + n_in) * 5 / CHAR_BIT + 1;
+	}
+
+	template <typename State>
+	static inline ssize_t stream_decode_data(State *__restrict state, unsigned char *__restrict out, size_t n_out, const char *__restrict in, size_t n_in) noexcept {
+		if (BECH32_UNLIKELY(n_out < stream_decoded_size(state, n_in)))
+			return BECH32_BUFFER_INADEQUATE;
+		if (BECH32_UNLIKELY(__builtin_add_overflow(state->n_in, n_in, &state->n_in) || state->n_in > state->n_max))
+			return BECH32_TOO_LONG;
+		unsigned char *p = out;
+		enum bech32_error error;
+		if (!state->n_hrp) {
+			size_t n = STREAM_BUFFER_SIZE - state->n_buf;
+			if (n > n_in)
+				n = n_in;
+			::memcpy(state->buf + state->n_buf, in, n);
+			state->n_buf += n, in += n, n_in -= n;
+			if (!n_in)
+				return 0;
+			if (BECH32_UNLIKELY((error = stream_decode_resolve(state, p)) < 0))
+				return error;
+		}
+		for (const char *end = in + n_in; in != end;)
+			if (BECH32_UNLIKELY((error = stream_decode_char(state, *in++, p)) < 0))
+				return error;
+		return p - out;
+	}
+
+	template <typename State>
+	static inline ssize_t stream_decode_finish(State *__restrict state, unsigned char *__restrict out, size_t n_out, checksum_t constant) noexcept {
+		if (BECH32_UNLIKELY(n_out < stream_decoded_size(state, 0)))
+			return BECH32_BUFFER_INADEQUATE;
+		if (BECH32_UNLIKELY(state->n_in < MIN_SIZE))
+			return BECH32_TOO_SHORT;
+		unsigned char *p = out;
+		enum bech32_error error;
+		if (!state->n_hrp && BECH32_UNLIKELY((error = stream_decode_resolve(state, p)) < 0))
+			return error;
+		if (BECH32_UNLIKELY(state->cases == 3))
+			return BECH32_MIXED_CASE;
+		if (BECH32_UNLIKELY(state->n_tail < CHECKSUM_SIZE))
+			return BECH32_TOO_SHORT;
+		if (BECH32_UNLIKELY(state->nbits >= 5 || state->nbits && (state->bits & (1 << state->nbits) - 1)))
+			return BECH32_PADDING_ERROR;
+		if (BECH32_UNLIKELY(state->chk != constant))
+			return BECH32_CHECKSUM_FAILURE;
+		return p - out;
+	}
+
+};
+
+
+/**
+ * @brief A #Code paired with the constant that is added to its checksum, such as Bech32 or Bech32m.
+ * @tparam BCH An instantiation of #Code.
+ * @tparam Constant The checksum constant.
+ */
+template <typename BCH, typename BCH::checksum_t Constant>
+struct Variant : BCH {
+
+	using code_t = BCH;
+	using typename BCH::checksum_t;
+
+	static constexpr checksum_t CONSTANT = Constant;
+
+	template <typename State>
+	static inline enum bech32_error encode_finish(State *__restrict state) noexcept {
+		return BCH::encode_finish(state, CONSTANT);
+	}
+
+	template <typename State>
+	static inline ssize_t decode_finish(State *__restrict state) noexcept {
+		return BCH::decode_finish(state, CONSTANT);
+	}
+
+};
+
+
+/**
+ * @brief A Segregated Witness address format built atop a pair of #Variant instantiations.
+ * @tparam V0 The variant used for witness version 0.
+ * @tparam V1 The variant used for all higher witness versions.
+ * @tparam ProgramMinSize The minimum size of a witness program.
+ * @tparam ProgramMaxSize The maximum size of a witness program.
+ * @tparam ProgramPkhSize The size of a version-0 pay-to-pubkey-hash witness program.
+ * @tparam ProgramShSize The size of a version-0 pay-to-script-hash witness program.
+ */
+template <typename V0, typename V1, size_t ProgramMinSize, size_t ProgramMaxSize, size_t ProgramPkhSize, size_t ProgramShSize>
+struct Address {
+
+	static_assert(std::is_same_v<typename V0::code_t, typename V1::code_t>, "variants must share a code");
+
+	using code_t = typename V0::code_t;
+	using v0_t = V0;
+	using v1_t = V1;
+
+	static constexpr size_t
+		PROGRAM_MIN_SIZE = ProgramMinSize,
+		PROGRAM_MAX_SIZE = ProgramMaxSize,
+		PROGRAM_PKH_SIZE = ProgramPkhSize,
+		PROGRAM_SH_SIZE = ProgramShSize,
+		ADDRESS_MIN_SIZE = code_t::HRP_MIN_SIZE + 1/*separator*/ + 1/*version*/ +
+				((PROGRAM_MIN_SIZE * CHAR_BIT + 4) / 5) + code_t::CHECKSUM_SIZE;
+
+	template <typename EncoderState>
+	static inline ssize_t encode(char *__restrict address, size_t n_address, const unsigned char *__restrict program, size_t n_program, const char *__restrict hrp, size_t n_hrp, unsigned version) noexcept {
+		if (BECH32_UNLIKELY(n_program < PROGRAM_MIN_SIZE))
+			return SEGWIT_PROGRAM_TOO_SHORT;
+		if (BECH32_UNLIKELY(n_program > PROGRAM_MAX_SIZE))
+			return SEGWIT_PROGRAM_TOO_LONG;
+		if (BECH32_UNLIKELY(version > WITNESS_MAX_VERSION))
+			return SEGWIT_VERSION_ILLEGAL;
+		if (version == 0 && BECH32_UNLIKELY(!(n_program == PROGRAM_PKH_SIZE || n_program == PROGRAM_SH_SIZE)))
+			return SEGWIT_PROGRAM_ILLEGAL_SIZE;
+		size_t n_actual = n_hrp + 1/*separator*/ + 1/*version*/ + (n_program * CHAR_BIT + 4) / 5 + code_t::CHECKSUM_SIZE;
+		if (BECH32_UNLIKELY(n_address < n_actual + 1/*null terminator*/))
+			return BECH32_BUFFER_INADEQUATE;
+		enum bech32_error error;
+		EncoderState state;
+		auto ver = static_cast<uint8_t>(version);
+		if (BECH32_UNLIKELY((error = code_t::encode_begin(&state, address, n_address, hrp, n_hrp)) < 0 ||
+				(error = code_t::encode_data(&state, &ver, 5)) < 0 ||
+				(error = code_t::encode_data(&state, program, n_program * CHAR_BIT)) < 0 ||
+				(error = version == 0 ? V0::encode_finish(&state) : V1::encode_finish(&state)) < 0))
+			return error;
+		address[n_actual] = '\0';
+		return static_cast<ssize_t>(n_actual);
+	}
+
+	/**
+	 * @brief Decodes an address in a single forward pass over its characters.
+	 *
+	 * Validation, case checking, checksumming, and unpacking of the witness program all happen in the same loop. The
+	 * checksum of the human-readable prefix is accumulated from its high and low bits in two separate registers, which are
+	 * combined once the separator is reached, since the BCH code is linear. An input that would fail any check other than
+	 * case, padding, or checksum is handed to #decode_stepwise, so the results and error codes are identical.
+	 */
+	template <typename DecoderState>
+	static inline ssize_t decode(unsigned char *__restrict program, size_t n_program, const char *__restrict address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) noexcept {
+		using checksum_t = typename code_t::checksum_t;
+		if (BECH32_UNLIKELY(n_address < ADDRESS_MIN_SIZE))
+			return BECH32_TOO_SHORT;
+		if (BECH32_UNLIKELY(n_address > code_t::MAX_SIZE))
+			return BECH32_TOO_LONG;
+		const char *p = address, *const end = address + n_address;
+		typename code_t::HrpAccumulator acc;
+		for (char c; p != end && (c = *p) != '1'; ++p)
+			acc.update(c);
+		size_t hrp = p - address, n_data = end - p - 1/*separator*/;
+		if (BECH32_UNLIKELY(p == end || acc.illegal || hrp < code_t::HRP_MIN_SIZE || hrp > code_t::HRP_MAX_SIZE ||
+				n_data < 1/*version*/ + code_t::CHECKSUM_SIZE))
+			return decode_stepwise<DecoderState>(program, n_program, address, n_address, n_hrp, version);
+		size_t n_actual = (n_data - 1/*version*/ - code_t::CHECKSUM_SIZE) * 5 / CHAR_BIT;
+		if (BECH32_UNLIKELY(n_actual < PROGRAM_MIN_SIZE || n_actual > PROGRAM_MAX_SIZE || n_program < n_actual))
+			return decode_stepwise<DecoderState>(program, n_program, address, n_address, n_hrp, version);
+		checksum_t chk = acc.finish(hrp);
+		unsigned cases = acc.cases;
+		int_fast32_t v;
+		auto next = [&]() noexcept {
+			char c = *++p;
+			cases |= (c >= 'a') | (c >= 'A' && c <= 'Z') << 1;
+			if (BECH32_UNLIKELY((v = static_cast<int_fast32_t>(c) - '0') < 0 || v > 'z' - '0' || (v = DECODE[v]) < 0))
+				return false;
+			chk = code_t::polymod(chk) ^ v;
+			return true;
+		};
+		if (BECH32_UNLIKELY(!next()))
+			return decode_stepwise<DecoderState>(program, n_program, address, n_address, n_hrp, version);
+		auto ver = static_cast<unsigned>(v);
+		if (BECH32_UNLIKELY(ver > WITNESS_MAX_VERSION || ver == 0 && !(n_actual == PROGRAM_PKH_SIZE || n_actual == PROGRAM_SH_SIZE)))
+			return decode_stepwise<DecoderState>(program, n_program, address, n_address, n_hrp, version);
+		uint_fast32_t bits = 0;
+		unsigned nbits = 0;
+		unsigned char *out = program;
+		for (size_t i = n_data - 1/*version*/ - code_t::CHECKSUM_SIZE; i; --i) {
+			if (BECH32_UNLIKELY(!next()))
+				return decode_stepwise<DecoderState>(program, n_program, address, n_address, n_hrp, version);
+			bits = bits << 5 | v, nbits += 5;
+			if (nbits >= CHAR_BIT)
+				*out++ = static_cast<unsigned char>(bits >> (nbits -= CHAR_BIT));
+		}
+		for (size_t i = code_t::CHECKSUM_SIZE; i; --i)
+			if (BECH32_UNLIKELY(!next()))
+				return decode_stepwise<DecoderState>(program, n_program, address, n_address, n_hrp, version);
+		if (BECH32_UNLIKELY(cases == 3))
+			return BECH32_MIXED_CASE;
+		*n_hrp = hrp, *version = ver;
+		if (BECH32_UNLIKELY(nbits >= 5 || bits & (1 << nbits) - 1))
+			return BECH32_PADDING_ERROR;
+		if (BECH32_UNLIKELY(chk != (ver == 0 ? V0::CONSTANT : V1::CONSTANT)))
+			return BECH32_CHECKSUM_FAILURE;
+		return n_actual;
+	}
+
+	/**
+	 * @brief Decodes an address in place, writing its witness program over the address, beginning immediately after the
+	 * separator.
+	 *
+	 * The program trails the characters from which it is decoded, so each byte overwrites only characters that have already
+	 * been consumed, and the human-readable prefix is left intact. The checksum characters are not overwritten, so they remain
+	 * available to be verified last.
+	 */
+	template <typename DecoderState>
+	static inline ssize_t decode_in_place(char *address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) noexcept {
+		if (BECH32_UNLIKELY(n_address < ADDRESS_MIN_SIZE))
+			return BECH32_TOO_SHORT;
+		ssize_t ret;
+		DecoderState state;
+		if (BECH32_UNLIKELY((ret = code_t::decode_begin(&state, address, n_address)) < 0))
+			return ret;
+		size_t hrp = static_cast<size_t>(ret);
+		size_t n_actual = (n_address - hrp - 1/*separator*/ - 1/*version*/ - code_t::CHECKSUM_SIZE) * 5 / CHAR_BIT;
+		if (BECH32_UNLIKELY(n_actual < PROGRAM_MIN_SIZE))
+			return SEGWIT_PROGRAM_TOO_SHORT;
+		if (BECH32_UNLIKELY(n_actual > PROGRAM_MAX_SIZE))
+			return SEGWIT_PROGRAM_TOO_LONG;
+		uint8_t ver;
+		if (BECH32_UNLIKELY((ret = code_t::decode_data(&state, &ver, 5)) < 0))
+			return ret;
+		if (BECH32_UNLIKELY(ver > WITNESS_MAX_VERSION))
+			return SEGWIT_VERSION_ILLEGAL;
+		else if (ver == 0 && BECH32_UNLIKELY(!(n_actual == PROGRAM_PKH_SIZE || n_actual == PROGRAM_SH_SIZE)))
+			return SEGWIT_PROGRAM_ILLEGAL_SIZE;
+		*n_hrp = hrp, *version = ver;
+		if (BECH32_UNLIKELY((ret = code_t::decode_data(&state, reinterpret_cast<unsigned char *>(address + hrp + 1/*separator*/), n_actual * CHAR_BIT)) < 0 ||
+				(ret = ver == 0 ? V0::decode_finish(&state) : V1::decode_finish(&state)) < 0))
+			return ret;
+		return n_actual;
+	}
+
+	/**
+	 * @brief Decodes an address using the low-level decoder, one step at a time.
+	 */
+	template <typename DecoderState>
+	static inline ssize_t decode_stepwise(unsigned char *__restrict program, size_t n_program, const char *__restrict address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) noexcept {
+		if (BECH32_UNLIKELY(n_address < ADDRESS_MIN_SIZE))
+			return BECH32_TOO_SHORT;
+		ssize_t ret;
+		DecoderState state;
+		if (BECH32_UNLIKELY((ret = code_t::decode_begin(&state, address, n_address)) < 0))
+			return ret;
+		size_t n_actual = (n_address - ret/*hrp*/ - 1/*separator*/ - 1/*version*/ - code_t::CHECKSUM_SIZE) * 5 / CHAR_BIT;
+		if (BECH32_UNLIKELY(n_actual < PROGRAM_MIN_SIZE))
+			return SEGWIT_PROGRAM_TOO_SHORT;
+		if (BECH32_UNLIKELY(n_actual > PROGRAM_MAX_SIZE))
+			return SEGWIT_PROGRAM_TOO_LONG;
+		if (BECH32_UNLIKELY(n_program < n_actual))
+			return BECH32_BUFFER_INADEQUATE;
+		*n_hrp = static_cast<size_t>(ret);
+		uint8_t ver;
+		if (BECH32_UNLIKELY((ret = code_t::decode_data(&state, &ver, 5)) < 0))
+			return ret;
+		if (BECH32_UNLIKELY(ver > WITNESS_MAX_VERSION))
+			return SEGWIT_VERSION_ILLEGAL;
+		else if (ver == 0 && BECH32_UNLIKELY(!(n_actual == PROGRAM_PKH_SIZE || n_actual == PROGRAM_SH_SIZE)))
+			return SEGWIT_PROGRAM_ILLEGAL_SIZE;
+		*version = ver;
+		if (BECH32_UNLIKELY((ret = code_t::decode_data(&state, program, n_actual * CHAR_BIT)) < 0 ||
+				(ret = ver == 0 ? V0::decode_finish(&state) : V1::decode_finish(&state)) < 0))
+			return ret;
+		return n_actual;
+	}
+
+};
+
+
+/**
+ * @brief Codec for addresses whose witness programs are of a size fixed at compile time.
+ * @tparam Address An instantiation of #Address.
+ * @tparam ProgramSize The size of the witness program in bytes.
+ *
+ * As the layout of the data part is known at compile time, the conversions between bytes and 5-bit groups and the checksum
+ * loops are fully unrolled, the checksum is computed in independent segments that are shifted into place by polymod_n, and
+ * validation accumulates its failures without branching until the end. An input that fails any
+ * check is handed to the generic #Address, so the results and error codes are identical, except that decoding a valid
+ * address whose program is of another size fails with @c SEGWIT_PROGRAM_ILLEGAL_SIZE.
+ */
+template <typename Address, size_t ProgramSize>
+struct FixedAddress {
+
+	using code_t = typename Address::code_t;
+	using checksum_t = typename code_t::checksum_t;
+
+	static_assert(ProgramSize >= Address::PROGRAM_MIN_SIZE && ProgramSize <= Address::PROGRAM_MAX_SIZE, "illegal program size");
+
+	static constexpr size_t
+		PROGRAM_SIZE = ProgramSize,
+		PROGRAM_CHARS = (PROGRAM_SIZE * CHAR_BIT + 4) / 5,
+		DATA_SIZE = 1/*version*/ + PROGRAM_CHARS + code_t::CHECKSUM_SIZE;
+
+private:
+	static constexpr bool V0_LEGAL = PROGRAM_SIZE == Address::PROGRAM_PKH_SIZE || PROGRAM_SIZE == Address::PROGRAM_SH_SIZE;
+
+	static inline void unpack(uint_fast8_t *__restrict out, const unsigned char *__restrict in) noexcept {
+#pragma GCC unroll 16
+		for (size_t i = 0; i < PROGRAM_SIZE / 5; ++i, in += 5, out += 8) {
+			uint_fast64_t x = static_cast<uint_fast64_t>(in[0]) << 32 | static_cast<uint_fast64_t>(in[1]) << 24 |
+					static_cast<uint_fast64_t>(in[2]) << 16 | static_cast<uint_fast64_t>(in[3]) << 8 | in[4];
+#pragma GCC unroll 8
+			for (unsigned j = 0; j < 8; ++j)
+				out[j] = static_cast<uint_fast8_t>(x >> (35 - 5 * j) & 0x1F);
+		}
+		if constexpr (constexpr size_t n_tail = PROGRAM_SIZE % 5; n_tail != 0) {
+			constexpr size_t n_chars = (n_tail * CHAR_BIT + 4) / 5;
+			uint_fast64_t x = 0;
+#pragma GCC unroll 4
+			for (size_t j = 0; j < n_tail; ++j)
+				x = x << CHAR_BIT | in[j];
+			x <<= n_chars * 5 - n_tail * CHAR_BIT;
+#pragma GCC unroll 8
+			for (size_t j = 0; j < n_chars; ++j)
+				out[j] = static_cast<uint_fast8_t>(x >> 5 * (n_chars - 1 - j) & 0x1F);
+		}
+	}
+
+	// Returns the padding bits, which must be zero.
+	static inline uint_fast64_t pack(unsigned char *__restrict out, const uint_fast8_t *__restrict in) noexcept {
+#pragma GCC unroll 16
+		for (size_t i = 0; i < PROGRAM_SIZE / 5; ++i, in += 8, out += 5) {
+			uint_fast64_t x = 0;
+#pragma GCC unroll 8
+			for (unsigned j = 0; j < 8; ++j)
+				x = x << 5 | in[j];
+#pragma GCC unroll 5
+			for (unsigned j = 0; j < 5; ++j)
+				out[j] = static_cast<unsigned char>(x >> (32 - CHAR_BIT * j));
+		}
+		if constexpr (constexpr size_t n_tail = PROGRAM_SIZE % 5; n_tail != 0) {
+			constexpr size_t n_chars = (n_tail * CHAR_BIT + 4) / 5, n_pad = n_chars * 5 - n_tail * CHAR_BIT;
+			uint_fast64_t x = 0;
+#pragma GCC unroll 8
+			for (size_t j = 0; j < n_chars; ++j)
+				x = x << 5 | in[j];
+#pragma GCC unroll 4
+			for (size_t j = 0; j < n_tail; ++j)
+				out[j] = static_cast<unsigned char>(x >> (n_pad + CHAR_BIT * (n_tail - 1 - j)));
+			return x & ((static_cast<uint_fast64_t>(1) << n_pad) - 1);
+		}
+		return 0;
+	}
+
+	// The checksum of the data part is computed in this many independent segments, which are combined at the end, so that the
+	// chain of dependent polymod steps is shorter.
+	static constexpr size_t SEGMENTS = 4;
+
+	template <size_t Begin, size_t End>
+	static inline checksum_t segment(const uint_fast8_t *__restrict data) noexcept {
+		checksum_t chk = 0;
+#pragma GCC unroll 64
+		for (size_t i = Begin; i < End; ++i)
+			chk = code_t::polymod(chk) ^ data[i];
+		return code_t::template polymod_n<DATA_SIZE - End>(chk);
+	}
+
+	// Returns the checksum of the given state of the human-readable prefix followed by the N values of the data part at data,
+	// padded with zeros to DATA_SIZE values.
+	template <size_t N, size_t... S>
+	static inline checksum_t checksum(checksum_t chk, const uint_fast8_t *__restrict data, std::index_sequence<S...>) noexcept {
+		return (code_t::template polymod_n<DATA_SIZE>(chk) ^ ... ^ segment<N * S / SEGMENTS, N * (S + 1) / SEGMENTS>(data));
+	}
+
+	template <typename DecoderState>
+	static ssize_t __attribute__ ((__cold__, __noinline__)) decode_generic(unsigned char *__restrict program, const char *__restrict address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) noexcept {
+		unsigned char buf[Address::PROGRAM_MAX_SIZE];
+		ssize_t ret = Address::template decode<DecoderState>(buf, sizeof buf, address, n_address, n_hrp, version);
+		if (ret < 0)
+			return ret;
+		if (static_cast<size_t>(ret) != PROGRAM_SIZE)
+			return SEGWIT_PROGRAM_ILLEGAL_SIZE;
+		::memcpy(program, buf, PROGRAM_SIZE);
+		return ret;
+	}
+
+public:
+	/**
+	 * @brief Encodes an address, as Address::encode does for a program of size #PROGRAM_SIZE.
+	 */
+	template <typename EncoderState>
+	static inline ssize_t encode(char *__restrict address, size_t n_address, const unsigned char *__restrict program, const char *__restrict hrp, size_t n_hrp, unsigned version) noexcept {
+		if (BECH32_UNLIKELY(n_hrp < code_t::HRP_MIN_SIZE || n_hrp > code_t::HRP_MAX_SIZE || version > WITNESS_MAX_VERSION ||
+				version == 0 && !V0_LEGAL || n_address <= n_hrp + 1/*separator*/ + DATA_SIZE))
+			return Address::template encode<EncoderState>(address, n_address, program, PROGRAM_SIZE, hrp, n_hrp, version);
+		bool illegal = false;
+		for (size_t i = 0; i < n_hrp; ++i)
+			illegal |= hrp[i] < 0x21 || hrp[i] >= 0x7F;
+		if (BECH32_UNLIKELY(illegal))
+			return Address::template encode<EncoderState>(address, n_address, program, PROGRAM_SIZE, hrp, n_hrp, version);
+		checksum_t chk = code_t::polymod_hrp(1, hrp, n_hrp);
+		for (size_t i = 0; i < n_hrp; ++i)
+			address[i] = static_cast<char>(hrp[i] | (hrp[i] >= 'A' && hrp[i] <= 'Z' ? 0x20 : 0));
+		char *out = address + n_hrp;
+		*out++ = '1';
+		uint_fast8_t data[1/*version*/ + PROGRAM_CHARS];
+		data[0] = static_cast<uint_fast8_t>(version);
+		unpack(data + 1, program);
+#pragma GCC unroll 128
+		for (size_t i = 0; i < 1/*version*/ + PROGRAM_CHARS; ++i)
+			out[i] = ENCODE[data[i]];
+		out += 1/*version*/ + PROGRAM_CHARS;
+		chk = checksum<1/*version*/ + PROGRAM_CHARS>(chk, data, std::make_index_sequence<SEGMENTS>());
+		chk ^= version == 0 ? Address::v0_t::CONSTANT : Address::v1_t::CONSTANT;
+#pragma GCC unroll 16
+		for (size_t i = 0; i < code_t::CHECKSUM_SIZE; ++i)
+			out[i] = ENCODE[chk >> 5 * (code_t::CHECKSUM_SIZE - 1 - i) & 0x1F];
+		out[code_t::CHECKSUM_SIZE] = '\0';
+		return static_cast<ssize_t>(n_hrp + 1/*separator*/ + DATA_SIZE);
+	}
+
+	/**
+	 * @brief Decodes an address, as Address::decode does, into a buffer of size #PROGRAM_SIZE.
+	 * @return #PROGRAM_SIZE, or a negative error code.
+	 */
+	template <typename DecoderState>
+	static inline ssize_t decode(unsigned char *__restrict program, const char *__restrict address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) noexcept {
+		if (BECH32_UNLIKELY(n_address < code_t::HRP_MIN_SIZE + 1/*separator*/ + DATA_SIZE || n_address > code_t::MAX_SIZE ||
+				address[n_address - DATA_SIZE - 1] != '1'))
+			return decode_generic<DecoderState>(program, address, n_address, n_hrp, version);
+		size_t hrp = n_address - DATA_SIZE - 1/*separator*/;
+		typename code_t::HrpAccumulator acc;
+		for (size_t i = 0; i < hrp; ++i)
+			acc.update(address[i]);
+		checksum_t chk = acc.finish(hrp);
+		unsigned cases = acc.cases;
+		const char *in = address + hrp + 1/*separator*/;
+		uint_fast8_t data[DATA_SIZE];
+		unsigned flags = 0;
+#pragma GCC unroll 128
+		for (size_t i = 0; i < DATA_SIZE; ++i) {
+			uint_fast8_t v = DECODE_FLAGS[static_cast<unsigned char>(in[i])];
+			flags |= v, data[i] = v & 0x1F;
+		}
+		cases |= (flags & DECODE_LOWER ? 1 : 0) | (flags & DECODE_UPPER ? 2 : 0);
+		chk = checksum<DATA_SIZE>(chk, data, std::make_index_sequence<SEGMENTS>());
+		unsigned ver = data[0];
+		uint_fast64_t padding = pack(program, data + 1);
+		if (BECH32_UNLIKELY(acc.illegal | (flags & DECODE_ILLEGAL) != 0 | cases == 3 | ver > WITNESS_MAX_VERSION | (ver == 0 && !V0_LEGAL) | padding != 0 |
+				chk != (ver == 0 ? Address::v0_t::CONSTANT : Address::v1_t::CONSTANT)))
+			return decode_generic<DecoderState>(program, address, n_address, n_hrp, version);
+		*n_hrp = hrp, *version = ver;
+		return static_cast<ssize_t>(PROGRAM_SIZE);
+	}
+
+};
+
+
+using Bech32Code = Code<bech32_checksum_t, BECH32_CHECKSUM_SIZE, BECH32_MAX_SIZE,
+		UINT32_C(0x3b6a57b2), UINT32_C(0x26508e6d), UINT32_C(0x1ea119fa), UINT32_C(0x3d4233dd), UINT32_C(0x2a1462b3)>;
+using Bech32 = Variant<Bech32Code, 1>;
+using Bech32m = Variant<Bech32Code, BECH32M_CONST>;
+using SegwitAddress = Address<Bech32, Bech32m,
+		WITNESS_PROGRAM_MIN_SIZE, WITNESS_PROGRAM_MAX_SIZE, WITNESS_PROGRAM_PKH_SIZE, WITNESS_PROGRAM_SH_SIZE>;
+
+#ifndef DISABLE_BLECH32
+using Blech32Code = Code<blech32_checksum_t, BLECH32_CHECKSUM_SIZE, BLECH32_MAX_SIZE,
+		UINT64_C(0x7d52fba40bd886), UINT64_C(0x5e8dbf1a03950c), UINT64_C(0x1c3a3c74072a18), UINT64_C(0x385d72fa0e5139), UINT64_C(0x7093e5a608865b)>;
+using Blech32 = Variant<Blech32Code, 1>;
+using Blech32m = Variant<Blech32Code, BLECH32M_CONST>;
+using BlindingAddress = Address<Blech32, Blech32m,
+		BLINDING_PROGRAM_MIN_SIZE, BLINDING_PROGRAM_MAX_SIZE, BLINDING_PROGRAM_PKH_SIZE, BLINDING_PROGRAM_SH_SIZE>;
+#endif
+
+
+} // namespace bch
+} // namespace bech32
+
+#undef BECH32_UNLIKELY
+#undef BECH32_LIKELY
+
+#endif // !defined(BECH32_BCH_H_INCLUDED)
@@ -0,0 +1,151 @@
+/// @file
+/// @brief Definitions of the C API's codec functions, which the library compiles as external functions and which bech32.h
+/// includes as static inline functions if @c BECH32_HEADER_ONLY is defined.
+#ifndef BECH32_IMPL_H_INCLUDED
+#define BECH32_IMPL_H_INCLUDED
+
+#include "bech32_bch.h"
+
+
+BECH32_API size_t bech32_encoded_size(size_t n_hrp, size_t nbits_in, size_t n_pad) {
+	return bech32::bch::Bech32Code::encoded_size(n_hrp, nbits_in, n_pad);
+}
+
+BECH32_API enum bech32_error bech32_encode_begin(struct bech32_encoder_state *__restrict state, char *__restrict out, size_t n_out, const char *__restrict hrp, size_t n_hrp) {
+	return bech32::bch::Bech32Code::encode_begin(state, out, n_out, hrp, n_hrp);
+}
+
+BECH32_API enum bech32_error bech32_encode_data(struct bech32_encoder_state *__restrict state, const unsigned char *__restrict in, size_t nbits_in) {
+	return bech32::bch::Bech32Code::encode_data(state, in, nbits_in);
+}
+
+BECH32_API enum bech32_error bech32_encode_finish(struct bech32_encoder_state *__restrict state, bech32_constant_t constant) {
+	return bech32::bch::Bech32Code::encode_finish(state, constant);
+}
+
+BECH32_API ssize_t bech32_decode_begin(struct bech32_decoder_state *__restrict state, const char *__restrict in, size_t n_in) {
+	return bech32::bch::Bech32Code::decode_begin(state, in, n_in);
+}
+
+BECH32_API enum bech32_error bech32_decode_data(struct bech32_decoder_state *__restrict state, unsigned char *out, size_t nbits_out) {
+	return bech32::bch::Bech32Code::decode_data(state, out, nbits_out);
+}
+
+BECH32_API ssize_t bech32_decode_finish(struct bech32_decoder_state *__restrict state, bech32_constant_t constant) {
+	return bech32::bch::Bech32Code::decode_finish(state, constant);
+}
+
+BECH32_API ssize_t bech32_decode_finish_detect(struct bech32_decoder_state *__restrict state, bech32_constant_t *__restrict constant) {
+	bech32::bch::Bech32Code::checksum_t chk;
+	ssize_t ret = bech32::bch::Bech32Code::decode_finish_detect(state, &chk, bech32::bch::Bech32::CONSTANT, bech32::bch::Bech32m::CONSTANT);
+	if (ret >= 0)
+		*constant = static_cast<bech32_constant_t>(chk);
+	return ret;
+}
+
+BECH32_API void bech32_stream_decode_begin(struct bech32_stream_decoder_state *__restrict state, size_t n_max) {
+	bech32::bch::Bech32Code::stream_decode_begin(state, n_max);
+}
+
+BECH32_API ssize_t bech32_stream_decode_data(struct bech32_stream_decoder_state *__restrict state, unsigned char *__restrict out, size_t n_out, const char *__restrict in, size_t n_in) {
+	return bech32::bch::Bech32Code::stream_decode_data(state, out, n_out, in, n_in);
+}
+
+BECH32_API ssize_t bech32_stream_decode_finish(struct bech32_stream_decoder_state *__restrict state, unsigned char *__restrict out, size_t n_out, bech32_constant_t constant) {
+	return bech32::bch::Bech32Code::stream_decode_finish(state, out, n_out, constant);
+}
+
+BECH32_API ssize_t bech32_address_encode(char *__restrict address, size_t n_address, const unsigned char *__restrict program, size_t n_program, const char *__restrict hrp, size_t n_hrp, unsigned version) {
+	return bech32::bch::SegwitAddress::encode<struct bech32_encoder_state>(address, n_address, program, n_program, hrp, n_hrp, version);
+}
+
+BECH32_API ssize_t bech32_address_decode(unsigned char *__restrict program, size_t n_program, const char *__restrict address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) {
+	return bech32::bch::SegwitAddress::decode<struct bech32_decoder_state>(program, n_program, address, n_address, n_hrp, version);
+}
+
+BECH32_API ssize_t bech32_address_decode_in_place(char *address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) {
+	return bech32::bch::SegwitAddress::decode_in_place<struct bech32_decoder_state>(address, n_address, n_hrp, version);
+}
+
+BECH32_API ssize_t bech32_address_encode_20(char *__restrict address, size_t n_address, const unsigned char *__restrict program, const char *__restrict hrp, size_t n_hrp, unsigned version) {
+	return bech32::bch::FixedAddress<bech32::bch::SegwitAddress, 20>::encode<struct bech32_encoder_state>(address, n_address, program, hrp, n_hrp, version);
+}
+
+BECH32_API ssize_t bech32_address_encode_32(char *__restrict address, size_t n_address, const unsigned char *__restrict program, const char *__restrict hrp, size_t n_hrp, unsigned version) {
+	return bech32::bch::FixedAddress<bech32::bch::SegwitAddress, 32>::encode<struct bech32_encoder_state>(address, n_address, program, hrp, n_hrp, version);
+}
+
+BECH32_API ssize_t bech32_address_decode_20(unsigned char *__restrict program, const char *__restrict address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) {
+	return bech32::bch::FixedAddress<bech32::bch::SegwitAddress, 20>::decode<struct bech32_decoder_state>(program, address, n_address, n_hrp, version);
+}
+
+BECH32_API ssize_t bech32_address_decode_32(unsigned char *__restrict program, const char *__restrict address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) {
+	return bech32::bch::FixedAddress<bech32::bch::SegwitAddress, 32>::decode<struct bech32_decoder_state>(program, address, n_address, n_hrp, version);
+}
+
+
+#ifndef DISABLE_BLECH32
+
+BECH32_API size_t blech32_encoded_size(size_t n_hrp, size_t nbits_in, size_t n_pad) {
+	return bech32::bch::Blech32Code::encoded_size(n_hrp, nbits_in, n_pad);
+}
+
+BECH32_API enum bech32_error blech32_encode_begin(struct blech32_encoder_state *__restrict state, char *__restrict out, size_t n_out, const char *__restrict hrp, size_t n_hrp) {
+	return bech32::bch::Blech32Code::encode_begin(state, out, n_out, hrp, n_hrp);
+}
+
+BECH32_API enum bech32_error blech32_encode_data(struct blech32_encoder_state *__restrict state, const unsigned char *__restrict in, size_t nbits_in) {
+	return bech32::bch::Blech32Code::encode_data(state, in, nbits_in);
+}
+
+BECH32_API enum bech32_error blech32_encode_finish(struct blech32_encoder_state *__restrict state, blech32_constant_t constant) {
+	return bech32::bch::Blech32Code::encode_finish(state, constant);
+}
+
+BECH32_API ssize_t blech32_decode_begin(struct blech32_decoder_state *__restrict state, const char *__restrict in, size_t n_in) {
+	return bech32::bch::Blech32Code::decode_begin(state, in, n_in);
+}
+
+BECH32_API enum bech32_error blech32_decode_data(struct blech32_decoder_state *__restrict state, unsigned char *out, size_t nbits_out) {
+	return bech32::bch::Blech32Code::decode_data(state, out, nbits_out);
+}
+
+BECH32_API ssize_t blech32_decode_finish(struct blech32_decoder_state *__restrict state, blech32_constant_t constant) {
+	return bech32::bch::Blech32Code::decode_finish(state, constant);
+}
+
+BECH32_API ssize_t blech32_decode_finish_detect(struct blech32_decoder_state *__restrict state, blech32_constant_t *__restrict constant) {
+	bech32::bch::Blech32Code::checksum_t chk;
+	ssize_t ret = bech32::bch::Blech32Code::decode_finish_detect(state, &chk, bech32::bch::Blech32::CONSTANT, bech32::bch::Blech32m::CONSTANT);
+	if (ret >= 0)
+		*constant = static_cast<blech32_constant_t>(chk);
+	return ret;
+}
+
+BECH32_API void blech32_stream_decode_begin(struct blech32_stream_decoder_state *__restrict state, size_t n_max) {
+	bech32::bch::Blech32Code::stream_decode_begin(state, n_max);
+}
+
+BECH32_API ssize_t blech32_stream_decode_data(struct blech32_stream_decoder_state *__restrict state, unsigned char *__restrict out, size_t n_out, const char *__restrict in, size_t n_in) {
+	return bech32::bch::Blech32Code::stream_decode_data(state, out, n_out, in, n_in);
+}
+
+BECH32_API ssize_t blech32_stream_decode_finish(struct blech32_stream_decoder_state *__restrict state, unsigned char *__restrict out, size_t n_out, blech32_constant_t constant) {
+	return bech32::bch::Blech32Code::stream_decode_finish(state, out, n_out, constant);
+}
+
+BECH32_API ssize_t blech32_address_encode(char *__restrict address, size_t n_address, const unsigned char *__restrict program, size_t n_program, const char *__restrict hrp, size_t n_hrp, unsigned version) {
+	return bech32::bch::BlindingAddress::encode<struct blech32_encoder_state>(address, n_address, program, n_program, hrp, n_hrp, version);
+}
+
+BECH32_API ssize_t blech32_address_decode(unsigned char *__restrict program, size_t n_program, const char *__restrict address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) {
+	return bech32::bch::BlindingAddress::decode<struct blech32_decoder_state>(program, n_program, address, n_address, n_hrp, version);
+}
+
+BECH32_API ssize_t blech32_address_decode_in_place(char *address, size_t n_address, size_t *__restrict n_hrp, unsigned *__restrict version) {
+	return bech32::bch::BlindingAddress::decode_in_place<struct blech32_decoder_state>(address, n_address, n_hrp, version);
+}
+
+#endif // !defined(DISABLE_BLECH32)
+
+#endif // !defined(BECH32_IMPL_H_INCLUDED)
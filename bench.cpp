@@ -0,0 +1,457 @@
+#include "bech32.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <climits>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <alloca.h>
+#include <getopt.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+// Each workload is run this many times to warm up the caches and resolve the library's symbols, and then this many times
+// again under measurement. The counts reported are per run.
+static constexpr unsigned ITERATIONS = 1000;
+
+// Single-stepping a workload takes thousands of times as long as running it, but it counts exactly the same instructions
+// every time, so a traced workload is warmed up as usual and then measured for just this many runs.
+static constexpr unsigned TRACED_ITERATIONS = 1;
+
+// The exit status by which Automake's test harness recognizes a skipped test, used when the host has no hardware counters
+// and does not permit tracing either.
+static constexpr int EXIT_SKIP = 77;
+
+
+// Counts the retired instructions and last-level cache misses of the calling thread in user space, as a group so that both
+// counters cover exactly the same span.
+class Counters {
+
+private:
+	int leader = -1, member = -1;
+
+public:
+	Counters() noexcept {
+		leader = open(PERF_COUNT_HW_INSTRUCTIONS, -1);
+		if (leader >= 0 && (member = open(PERF_COUNT_HW_CACHE_MISSES, leader)) < 0)
+			::close(leader), leader = -1;
+	}
+
+	~Counters() {
+		if (leader >= 0)
+			::close(member), ::close(leader);
+	}
+
+	Counters(const Counters &) = delete;
+	Counters & operator=(const Counters &) = delete;
+
+public:
+	explicit operator bool() const noexcept {
+		return leader >= 0;
+	}
+
+	void start() noexcept {
+		::ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		::ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+
+	void stop(uint64_t &instructions, uint64_t &cache_misses) {
+		::ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+		struct {
+			uint64_t n;
+			uint64_t values[2];
+		} group;
+		if (::read(leader, &group, sizeof group) != static_cast<ssize_t>(sizeof group) || group.n != 2) {
+			std::perror("read");
+			std::exit(EXIT_FAILURE);
+		}
+		instructions = group.values[0], cache_misses = group.values[1];
+	}
+
+private:
+	static int open(uint64_t config, int group_fd) noexcept {
+		struct perf_event_attr attr { };
+		attr.size = sizeof attr;
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = config;
+		attr.disabled = group_fd < 0;
+		attr.exclude_kernel = 1, attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP;
+		return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0/*this thread*/, -1/*any cpu*/, group_fd, 0));
+	}
+
+};
+
+
+static inline void check(ssize_t ret) {
+	if (ret < 0) {
+		std::fprintf(stderr, "workload failed with error %zd\n", ret);
+		std::exit(EXIT_FAILURE);
+	}
+}
+
+// Runs the tasks of a batch on the calling thread, in order, so that the batch functions are measured without the thread pool.
+static void inline_executor(void *, void (*task)(void *, size_t), void *arg, size_t n_tasks) {
+	for (size_t i = 0; i < n_tasks; ++i)
+		task(arg, i);
+}
+
+static constexpr struct bech32_executor INLINE_EXECUTOR = { &inline_executor, nullptr };
+
+static std::vector<unsigned char> pattern(size_t n, unsigned seed) {
+	std::vector<unsigned char> bytes(n);
+	for (size_t i = 0; i < n; ++i)
+		bytes[i] = static_cast<unsigned char>(i * 73 + seed);
+	return bytes;
+}
+
+
+struct Workload {
+	std::string name;
+	std::function<void ()> run;
+};
+
+template <typename EncoderState, typename DecoderState, typename StreamDecoderState, typename Constant, size_t max_size,
+		auto encode_begin, auto encode_data, auto encode_finish, auto decode_begin, auto decode_data, auto decode_finish,
+		auto stream_decode_begin, auto stream_decode_data, auto stream_decode_finish>
+static void add_codec(std::vector<Workload> &workloads, const char *prefix, const char *hrp, std::initializer_list<size_t> sizes, Constant constant) {
+	for (size_t n : sizes) {
+		auto bytes = std::make_shared<std::vector<unsigned char>>(pattern(n, static_cast<unsigned>(n)));
+		auto encoding = std::make_shared<std::string>(max_size, '\0');
+		EncoderState encoder;
+		check(encode_begin(&encoder, encoding->data(), encoding->size(), hrp, std::strlen(hrp)));
+		check(encode_data(&encoder, bytes->data(), n * CHAR_BIT));
+		check(encode_finish(&encoder, constant));
+		encoding->resize(static_cast<size_t>(encoder.out - encoding->data()));
+		std::string suffix = '/' + std::to_string(n);
+		workloads.push_back({ prefix + std::string("_encode") + suffix, [=] {
+			char out[max_size];
+			EncoderState state;
+			check(encode_begin(&state, out, sizeof out, hrp, std::strlen(hrp)));
+			check(encode_data(&state, bytes->data(), n * CHAR_BIT));
+			check(encode_finish(&state, constant));
+		} });
+		workloads.push_back({ prefix + std::string("_decode") + suffix, [=] {
+			unsigned char out[max_size];
+			DecoderState state;
+			check(decode_begin(&state, encoding->data(), encoding->size()));
+			check(decode_data(&state, out, n * CHAR_BIT));
+			check(decode_finish(&state, constant));
+		} });
+		workloads.push_back({ prefix + std::string("_stream_decode") + suffix, [=] {
+			unsigned char out[max_size];
+			StreamDecoderState state;
+			stream_decode_begin(&state, max_size);
+			ssize_t ret = stream_decode_data(&state, out, sizeof out, encoding->data(), encoding->size());
+			check(ret);
+			check(stream_decode_finish(&state, out + ret, sizeof out - static_cast<size_t>(ret), constant));
+		} });
+	}
+}
+
+template <size_t max_address, size_t max_program, auto address_encode, auto address_decode, auto address_decode_in_place, auto address_encode_batch, auto address_decode_batch>
+static void add_address(std::vector<Workload> &workloads, const char *prefix, const char *hrp, std::initializer_list<std::pair<size_t, unsigned>> programs) {
+	for (auto [n, version] : programs) {
+		auto program = std::make_shared<std::vector<unsigned char>>(pattern(n, static_cast<unsigned>(n)));
+		auto address = std::make_shared<std::string>(max_address + 1, '\0');
+		ssize_t n_address = address_encode(address->data(), address->size(), program->data(), n, hrp, std::strlen(hrp), version);
+		check(n_address);
+		address->resize(static_cast<size_t>(n_address));
+		// the size alone does not identify a program, as a P2SH and a P2TR blinding program are the same size
+		std::string suffix = "/v" + std::to_string(version) + "/" + std::to_string(n);
+		workloads.push_back({ prefix + std::string("_address_encode") + suffix, [=] {
+			char out[max_address + 1];
+			check(address_encode(out, sizeof out, program->data(), n, hrp, std::strlen(hrp), version));
+		} });
+		workloads.push_back({ prefix + std::string("_address_decode") + suffix, [=] {
+			unsigned char out[max_program];
+			size_t n_hrp;
+			unsigned v;
+			check(address_decode(out, sizeof out, address->data(), address->size(), &n_hrp, &v));
+		} });
+		workloads.push_back({ prefix + std::string("_address_decode_in_place") + suffix, [=] {
+			char buf[max_address];
+			std::memcpy(buf, address->data(), address->size());
+			size_t n_hrp;
+			unsigned v;
+			check(address_decode_in_place(buf, address->size(), &n_hrp, &v));
+		} });
+		// the items are too few for the batch functions to hand them to the executor, but it keeps them off the pool regardless
+		workloads.push_back({ prefix + std::string("_address_batch") + suffix, [=] {
+			static constexpr size_t N_ITEMS = 64;
+			char addresses[N_ITEMS][max_address + 1];
+			unsigned char programs[N_ITEMS][max_program];
+			struct bech32_address_encode_item encode_items[N_ITEMS];
+			struct bech32_address_decode_item decode_items[N_ITEMS];
+			for (size_t i = 0; i < N_ITEMS; ++i)
+				encode_items[i] = { addresses[i], sizeof addresses[i], program->data(), n, hrp, std::strlen(hrp), version, 0 };
+			address_encode_batch(encode_items, N_ITEMS, &INLINE_EXECUTOR);
+			for (size_t i = 0; i < N_ITEMS; ++i) {
+				check(encode_items[i].ret);
+				decode_items[i] = { programs[i], sizeof programs[i], addresses[i], static_cast<size_t>(encode_items[i].ret), 0, 0, 0 };
+			}
+			address_decode_batch(decode_items, N_ITEMS, &INLINE_EXECUTOR);
+			for (size_t i = 0; i < N_ITEMS; ++i)
+				check(decode_items[i].ret);
+		} });
+	}
+}
+
+static std::vector<Workload> workloads() {
+	std::vector<Workload> workloads;
+	add_codec<struct bech32_encoder_state, struct bech32_decoder_state, struct bech32_stream_decoder_state, bech32_constant_t, BECH32_MAX_SIZE,
+			&::bech32_encode_begin, &::bech32_encode_data, &::bech32_encode_finish,
+			&::bech32_decode_begin, &::bech32_decode_data, &::bech32_decode_finish,
+			&::bech32_stream_decode_begin, &::bech32_stream_decode_data, &::bech32_stream_decode_finish>(
+			workloads, "bech32", "bc", { 8, 32, 50 }, BECH32M_CONST);
+	add_address<BECH32_MAX_SIZE, WITNESS_PROGRAM_MAX_SIZE, &::bech32_address_encode, &::bech32_address_decode, &::bech32_address_decode_in_place,
+			&::bech32_address_encode_batch, &::bech32_address_decode_batch>(
+			workloads, "bech32", "bc", { { 2, 1 }, { WITNESS_PROGRAM_PKH_SIZE, 0 }, { WITNESS_PROGRAM_SH_SIZE, 0 }, { WITNESS_PROGRAM_MAX_SIZE, 1 } });
+	for (size_t n : { WITNESS_PROGRAM_PKH_SIZE, WITNESS_PROGRAM_SH_SIZE }) {
+		auto program = std::make_shared<std::vector<unsigned char>>(pattern(n, static_cast<unsigned>(n)));
+		auto address = std::make_shared<std::string>(BECH32_MAX_SIZE, '\0');
+		ssize_t n_address = ::bech32_address_encode(address->data(), address->size(), program->data(), n, "bc", 2, 0);
+		check(n_address);
+		address->resize(static_cast<size_t>(n_address));
+		auto encode_fixed = n == WITNESS_PROGRAM_PKH_SIZE ? &::bech32_address_encode_20 : &::bech32_address_encode_32;
+		auto decode_fixed = n == WITNESS_PROGRAM_PKH_SIZE ? &::bech32_address_decode_20 : &::bech32_address_decode_32;
+		std::string suffix = "_" + std::to_string(n);
+		workloads.push_back({ "bech32_address_encode" + suffix, [=] {
+			char out[BECH32_MAX_SIZE];
+			check(encode_fixed(out, sizeof out, program->data(), "bc", 2, 0));
+		} });
+		workloads.push_back({ "bech32_address_decode" + suffix, [=] {
+			unsigned char out[WITNESS_PROGRAM_SH_SIZE];
+			size_t n_hrp;
+			unsigned version;
+			check(decode_fixed(out, address->data(), address->size(), &n_hrp, &version));
+		} });
+		workloads.push_back({ "bech32_detect" + suffix, [=] {
+			check(::bech32_detect(address->data(), address->size()));
+		} });
+	}
+#ifndef DISABLE_BLECH32
+	add_codec<struct blech32_encoder_state, struct blech32_decoder_state, struct blech32_stream_decoder_state, blech32_constant_t, BLECH32_MAX_SIZE,
+			&::blech32_encode_begin, &::blech32_encode_data, &::blech32_encode_finish,
+			&::blech32_decode_begin, &::blech32_decode_data, &::blech32_decode_finish,
+			&::blech32_stream_decode_begin, &::blech32_stream_decode_data, &::blech32_stream_decode_finish>(
+			workloads, "blech32", "el", { 8, 53, 100, 600 }, BLECH32M_CONST);
+	add_address<BLECH32_MAX_SIZE, BLINDING_PROGRAM_MAX_SIZE, &::blech32_address_encode, &::blech32_address_decode, &::blech32_address_decode_in_place,
+			&::blech32_address_encode_batch, &::blech32_address_decode_batch>(
+			workloads, "blech32", "el", { { BLINDING_PROGRAM_PKH_SIZE, 0 }, { BLINDING_PROGRAM_SH_SIZE, 0 }, { BLINDING_PROGRAM_TR_SIZE, 1 } });
+#endif
+	return workloads;
+}
+
+
+struct Result {
+	double instructions, cache_misses;
+};
+
+static std::vector<Result> count(Counters &counters, const std::vector<Workload> &workloads) {
+	std::vector<Result> results;
+	for (const auto &workload : workloads) {
+		for (unsigned i = 0; i < ITERATIONS; ++i)
+			workload.run();
+		uint64_t instructions, cache_misses;
+		counters.start();
+		for (unsigned i = 0; i < ITERATIONS; ++i)
+			workload.run();
+		counters.stop(instructions, cache_misses);
+		results.push_back({ static_cast<double>(instructions) / ITERATIONS, static_cast<double>(cache_misses) / ITERATIONS });
+	}
+	return results;
+}
+
+// Runs the workloads in the traced child, marking each span to measure by raising a signal, after an empty span that measures
+// the instructions that the marking itself contributes.
+[[noreturn]] static void __attribute__ ((__noinline__)) run_traced(const std::vector<Workload> &workloads, int mark) {
+	std::raise(mark), std::raise(mark);
+	for (const auto &workload : workloads) {
+		for (unsigned i = 0; i < ITERATIONS; ++i)
+			workload.run();
+		std::raise(mark);
+		for (unsigned i = 0; i < TRACED_ITERATIONS; ++i)
+			workload.run();
+		std::raise(mark);
+	}
+	::_exit(EXIT_SUCCESS);
+}
+
+// Counts the instructions that each workload retires in user space without hardware counters, by running the workloads in a
+// child process that this one traces, single-stepping the measured runs. Cache misses cannot be counted so. Returns false
+// if the host does not permit tracing.
+static bool single_step(const std::vector<Workload> &workloads, std::vector<Result> &results) {
+	static constexpr int MARK = SIGUSR1;
+	pid_t pid = ::fork();
+	if (pid < 0) {
+		std::perror("fork");
+		std::exit(EXIT_FAILURE);
+	}
+	if (pid == 0) {
+		if (::ptrace(PTRACE_TRACEME, 0, nullptr, nullptr) < 0)
+			::_exit(EXIT_SKIP);
+		std::raise(SIGSTOP);
+		// the C library's memory and string functions take different paths by alignment, and the stack, unlike the heap and
+		// the libraries, is placed at a random offset within a page, so the workloads are run from the start of one
+		auto pad = static_cast<volatile char *>(alloca(4096 + reinterpret_cast<uintptr_t>(__builtin_frame_address(0)) % 4096));
+		pad[0] = 0;
+		run_traced(workloads, MARK);
+	}
+	uint64_t steps = 0, overhead = 0;
+	bool stepping = false, calibrated = false;
+	for (int status;;) {
+		if (::waitpid(pid, &status, 0) < 0) {
+			std::perror("waitpid");
+			std::exit(EXIT_FAILURE);
+		}
+		if (WIFEXITED(status)) {
+			if (WEXITSTATUS(status) == EXIT_SKIP && !calibrated)
+				return false;
+			if (WEXITSTATUS(status) != EXIT_SUCCESS || results.size() != workloads.size())
+				std::exit(EXIT_FAILURE);
+			return true;
+		}
+		if (WIFSIGNALED(status)) {
+			std::fprintf(stderr, "traced workloads were killed by signal %d\n", WTERMSIG(status));
+			std::exit(EXIT_FAILURE);
+		}
+		if (int sig = WSTOPSIG(status); sig == MARK) {
+			if (stepping) {
+				if (calibrated)
+					results.push_back({ static_cast<double>(steps - overhead) / TRACED_ITERATIONS, NAN });
+				else
+					overhead = steps, calibrated = true;
+			}
+			stepping = !stepping, steps = 0;
+		}
+		else if (sig == SIGTRAP && stepping)
+			++steps;
+		else if (sig != SIGSTOP) {
+			std::fprintf(stderr, "traced workloads stopped by signal %d\n", sig);
+			::kill(pid, SIGKILL);
+			std::exit(EXIT_FAILURE);
+		}
+		if (::ptrace(stepping ? PTRACE_SINGLESTEP : PTRACE_CONT, pid, nullptr, nullptr) < 0) {
+			std::perror("ptrace");
+			::kill(pid, SIGKILL);
+			std::exit(EXIT_FAILURE);
+		}
+	}
+}
+
+static std::map<std::string, Result> read_baseline(const char *path) {
+	FILE *file = std::fopen(path, "r");
+	if (!file) {
+		std::perror(path);
+		std::exit(EXIT_FAILURE);
+	}
+	std::map<std::string, Result> baseline;
+	char line[256], name[128];
+	Result result = { 0, NAN };
+	while (std::fgets(line, sizeof line, file))
+		if (line[0] != '#' && std::sscanf(line, "%127s %lf", name, &result.instructions) == 2)
+			baseline.emplace(name, result);
+	std::fclose(file);
+	return baseline;
+}
+
+static void usage(const char *argv0) {
+	std::fprintf(stderr, "usage: %s [-c BASELINE] [-t PERCENT]\n"
+			"\t-c, --compare=BASELINE\tcompare against a baseline and fail if any instruction count regressed\n"
+			"\t-t, --tolerance=PERCENT\tallow instruction counts to exceed the baseline by this much (default: 1)\n", argv0);
+	std::exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+	static const struct option longopts[] = {
+		{ "compare", required_argument, nullptr, 'c' },
+		{ "tolerance", required_argument, nullptr, 't' },
+		{ },
+	};
+	const char *compare = nullptr;
+	double tolerance = 1;
+	for (int opt; (opt = ::getopt_long(argc, argv, "c:t:", longopts, nullptr)) >= 0;)
+		switch (opt) {
+			case 'c':
+				compare = optarg;
+				break;
+			case 't': {
+				char *end;
+				tolerance = std::strtod(optarg, &end);
+				if (*end || tolerance < 0)
+					usage(argv[0]);
+				break;
+			}
+			default:
+				usage(argv[0]);
+		}
+	if (optind != argc)
+		usage(argv[0]);
+
+	// the workloads' data are allocated first, so that they lie at the same addresses whether or not a baseline is read
+	const std::vector<Workload> workloads = ::workloads();
+	std::map<std::string, Result> baseline;
+	if (compare)
+		baseline = read_baseline(compare);
+	if (compare && baseline.empty()) {
+		std::fprintf(stderr, "%s: %s: no workloads recorded; run `make bench-baseline` first\n", argv[0], compare);
+		return EXIT_FAILURE;
+	}
+
+	// single-stepping counts the same instructions as the hardware, so a baseline recorded either way serves for both
+	std::vector<Result> results;
+	const char *method = "hardware counters";
+	if (Counters counters; counters)
+		results = count(counters, workloads);
+	else if (int error = errno; !single_step(workloads, results)) {
+		std::fprintf(stderr, "%s: hardware performance counters are unavailable (%s), and tracing is not permitted\n", argv[0], std::strerror(error));
+		return EXIT_SKIP;
+	}
+	else
+		method = "single-stepping";
+
+	std::printf("# user-space counts per run of each workload by %s, as recorded by `make bench-baseline`\n"
+			"# workload\tinstructions\tcache-misses\n", method);
+	unsigned regressions = 0, missing = 0;
+	for (size_t i = 0; i < workloads.size(); ++i) {
+		const Workload &workload = workloads[i];
+		const Result &result = results[i];
+		if (std::isnan(result.cache_misses))
+			std::printf("%s\t%.1f\t-", workload.name.c_str(), result.instructions);
+		else
+			std::printf("%s\t%.1f\t%.3f", workload.name.c_str(), result.instructions, result.cache_misses);
+		if (compare) {
+			// only the instruction counts are gated, as cache misses depend on whatever else shares the host's caches; a
+			// workload absent from the baseline fails too, lest a stale baseline silently stop guarding it
+			if (auto it = baseline.find(workload.name); it == baseline.end())
+				std::printf("\t# MISSING from baseline"), ++missing;
+			else if (double delta = (result.instructions / it->second.instructions - 1) * 100; delta > tolerance)
+				std::printf("\t# REGRESSED %+.2f%%", delta), ++regressions;
+			else
+				std::printf("\t# %+.2f%%", delta);
+		}
+		std::putchar('\n');
+	}
+	if (missing)
+		std::fprintf(stderr, "%s: %u workload%s missing from %s; rerun `make bench-baseline`\n", argv[0], missing, missing == 1 ? " is" : "s are", compare);
+	if (regressions)
+		std::fprintf(stderr, "%s: %u workload%s regressed by more than %g%%\n", argv[0], regressions, regressions == 1 ? "" : "s", tolerance);
+	return regressions || missing ? EXIT_FAILURE : EXIT_SUCCESS;
+}
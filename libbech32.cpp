@@ -0,0 +1,8 @@
+#include "bech32_impl.h"
+
+
+// define weak aliases for ABI backward compatibility
+ssize_t segwit_address_encode(char *__restrict, size_t, const unsigned char *__restrict, size_t, const char *__restrict, size_t, unsigned)
+	__attribute__ ((__weak__, __alias__ ("bech32_address_encode")));
+ssize_t segwit_address_decode(unsigned char *__restrict, size_t, const char *__restrict, size_t, size_t *__restrict, unsigned *__restrict)
+	__attribute__ ((__weak__, __alias__ ("bech32_address_decode")));
@@ -0,0 +1,226 @@
+#include "bech32_bch.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include <stdlib.h>
+
+using namespace bech32::bch;
+
+
+namespace {
+
+
+constexpr char MAGIC[8] = { 'B', 'E', 'C', 'H', '3', '2', 'A', 'S' };
+
+constexpr unsigned KNOWN_FLAGS = BECH32_ADDRESS_SET_EYTZINGER
+#ifndef DISABLE_BLECH32
+		| BECH32_ADDRESS_SET_BLECH32
+#endif
+		;
+
+constexpr size_t PROGRAM_MAX_SIZE =
+#ifndef DISABLE_BLECH32
+		BlindingAddress::PROGRAM_MAX_SIZE;
+#else
+		SegwitAddress::PROGRAM_MAX_SIZE;
+#endif
+
+inline constexpr unsigned char __attribute__ ((__const__)) lower(char c) noexcept {
+	return static_cast<unsigned char>(c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+}
+
+struct Record {
+	const char *hrp;
+	uint16_t n_hrp;
+	uint8_t version, n_program;
+	unsigned char program[PROGRAM_MAX_SIZE];
+};
+
+inline int __attribute__ ((__pure__)) compare_group(const Record &a, const Record &b) noexcept {
+	if (a.n_hrp != b.n_hrp)
+		return a.n_hrp < b.n_hrp ? -1 : 1;
+	for (size_t i = 0; i < a.n_hrp; ++i)
+		if (lower(a.hrp[i]) != lower(b.hrp[i]))
+			return lower(a.hrp[i]) < lower(b.hrp[i]) ? -1 : 1;
+	if (a.version != b.version)
+		return a.version < b.version ? -1 : 1;
+	if (a.n_program != b.n_program)
+		return a.n_program < b.n_program ? -1 : 1;
+	return 0;
+}
+
+inline int __attribute__ ((__pure__)) compare(const Record &a, const Record &b) noexcept {
+	if (int cmp = compare_group(a, b))
+		return cmp;
+	return ::memcmp(a.program, b.program, a.n_program);
+}
+
+// Writes the programs of a sorted group of records into Eytzinger order, in which the children of the record at (one-based)
+// index k are at indices 2k and 2k+1. Returns the index in the group of the next record to place.
+size_t place_eytzinger(const Record records[], unsigned char *out, size_t n_records, size_t i, size_t k) noexcept {
+	if (k <= n_records) {
+		i = place_eytzinger(records, out, n_records, i, 2 * k);
+		::memcpy(out + (k - 1) * records[i].n_program, records[i].program, records[i].n_program);
+		i = place_eytzinger(records, out, n_records, i + 1, 2 * k + 1);
+	}
+	return i;
+}
+
+template <typename Address, typename DecoderState>
+ssize_t build(unsigned char **__restrict out, const char *const *__restrict addresses, size_t n_addresses, unsigned flags, size_t *__restrict bad) noexcept {
+	auto records = static_cast<Record *>(::malloc(n_addresses ? n_addresses * sizeof(Record) : 1));
+	if (!records)
+		return BECH32_BUFFER_INADEQUATE;
+	for (size_t i = 0; i < n_addresses; ++i) {
+		Record &record = records[i];
+		size_t n_hrp;
+		unsigned version;
+		ssize_t ret = Address::template decode<DecoderState>(record.program, sizeof record.program, addresses[i], ::strlen(addresses[i]), &n_hrp, &version);
+		if (ret < 0) {
+			::free(records);
+			*bad = i;
+			return ret;
+		}
+		record.hrp = addresses[i];
+		record.n_hrp = static_cast<uint16_t>(n_hrp);
+		record.version = static_cast<uint8_t>(version), record.n_program = static_cast<uint8_t>(ret);
+	}
+	std::sort(records, records + n_addresses, [](const Record &a, const Record &b) noexcept { return compare(a, b) < 0; });
+	size_t n_records = std::unique(records, records + n_addresses, [](const Record &a, const Record &b) noexcept { return compare(a, b) == 0; }) - records;
+
+	size_t n_groups = 0, size = sizeof(struct bech32_address_set_header);
+	for (size_t i = 0; i < n_records; ++i) {
+		if (i == 0 || compare_group(records[i - 1], records[i]))
+			++n_groups, size += sizeof(struct bech32_address_set_group) + records[i].n_hrp;
+		size += records[i].n_program;
+	}
+	auto file = static_cast<unsigned char *>(::calloc(size, 1));
+	if (!file) {
+		::free(records);
+		return BECH32_BUFFER_INADEQUATE;
+	}
+	struct bech32_address_set_header header { };
+	::memcpy(header.magic, MAGIC, sizeof header.magic);
+	header.format = BECH32_ADDRESS_SET_FORMAT, header.flags = flags, header.n_groups = n_groups;
+	::memcpy(file, &header, sizeof header);
+	auto groups = reinterpret_cast<struct bech32_address_set_group *>(file + sizeof header);
+	size_t hrp_offset = sizeof header + n_groups * sizeof *groups, offset = hrp_offset;
+	for (size_t i = 0; i < n_records;)
+		offset += records[i].n_hrp, i = std::find_if(records + i + 1, records + n_records, [&](const Record &record) noexcept {
+			return compare_group(records[i], record) != 0;
+		}) - records;
+	for (size_t i = 0, g = 0; i < n_records; ++g) {
+		const Record &first = records[i];
+		size_t end = std::find_if(records + i + 1, records + n_records, [&](const Record &record) noexcept {
+			return compare_group(first, record) != 0;
+		}) - records;
+		auto &group = groups[g];
+		group.offset = offset, group.n_records = end - i;
+		group.hrp_offset = hrp_offset, group.n_hrp = first.n_hrp;
+		group.version = first.version, group.n_program = first.n_program;
+		for (size_t j = 0; j < first.n_hrp; ++j)
+			file[hrp_offset++] = lower(first.hrp[j]);
+		if (flags & BECH32_ADDRESS_SET_EYTZINGER)
+			place_eytzinger(records + i, file + offset, end - i, 0, 1);
+		else
+			for (size_t j = i; j < end; ++j)
+				::memcpy(file + offset + (j - i) * first.n_program, records[j].program, first.n_program);
+		offset += (end - i) * first.n_program;
+		i = end;
+	}
+	::free(records);
+	*out = file;
+	return static_cast<ssize_t>(size);
+}
+
+bool __attribute__ ((__pure__)) search(const struct bech32_address_set *__restrict set, const struct bech32_address_set_group &group, const unsigned char *__restrict program) noexcept {
+	const unsigned char *records = set->data + group.offset;
+	size_t n_records = group.n_records, n_program = group.n_program;
+	if (set->flags & BECH32_ADDRESS_SET_EYTZINGER) {
+		size_t k = 1;
+		while (k <= n_records)
+			k = 2 * k + (::memcmp(records + (k - 1) * n_program, program, n_program) < 0);
+		// strip the trailing right turns and the final left turn to recover the lower bound
+		k >>= __builtin_ctzll(~static_cast<unsigned long long>(k)) + 1;
+		return k && ::memcmp(records + (k - 1) * n_program, program, n_program) == 0;
+	}
+	for (size_t lo = 0, hi = n_records; lo < hi;) {
+		size_t mid = lo + (hi - lo) / 2;
+		int cmp = ::memcmp(records + mid * n_program, program, n_program);
+		if (cmp == 0)
+			return true;
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return false;
+}
+
+template <typename Address, typename DecoderState>
+ssize_t contains(const struct bech32_address_set *__restrict set, const char *__restrict address, size_t n_address) noexcept {
+	unsigned char program[Address::PROGRAM_MAX_SIZE];
+	size_t n_hrp;
+	unsigned version;
+	ssize_t ret = Address::template decode<DecoderState>(program, sizeof program, address, n_address, &n_hrp, &version);
+	if (ret < 0)
+		return ret;
+	for (size_t g = 0; g < set->n_groups; ++g) {
+		const auto &group = set->groups[g];
+		if (group.n_hrp != n_hrp || group.version != version || group.n_program != static_cast<size_t>(ret))
+			continue;
+		const unsigned char *hrp = set->data + group.hrp_offset;
+		size_t i = 0;
+		while (i < n_hrp && hrp[i] == lower(address[i]))
+			++i;
+		if (i == n_hrp)
+			return search(set, group, program);
+	}
+	return 0;
+}
+
+
+} // namespace
+
+
+ssize_t bech32_address_set_build(unsigned char **__restrict out, const char *const *__restrict addresses, size_t n_addresses, unsigned flags, size_t *__restrict bad) {
+	flags &= KNOWN_FLAGS;
+#ifndef DISABLE_BLECH32
+	if (flags & BECH32_ADDRESS_SET_BLECH32)
+		return build<BlindingAddress, struct blech32_decoder_state>(out, addresses, n_addresses, flags, bad);
+#endif
+	return build<SegwitAddress, struct bech32_decoder_state>(out, addresses, n_addresses, flags, bad);
+}
+
+int bech32_address_set_open(struct bech32_address_set *__restrict set, const void *__restrict data, size_t n_data) {
+	struct bech32_address_set_header header;
+	if (n_data < sizeof header || reinterpret_cast<uintptr_t>(data) % alignof(struct bech32_address_set_group))
+		return -1;
+	::memcpy(&header, data, sizeof header);
+	if (::memcmp(header.magic, MAGIC, sizeof header.magic) != 0 || header.format != BECH32_ADDRESS_SET_FORMAT || header.flags & ~KNOWN_FLAGS ||
+			header.n_groups > (n_data - sizeof header) / sizeof(struct bech32_address_set_group))
+		return -1;
+	auto bytes = static_cast<const unsigned char *>(data);
+	auto groups = reinterpret_cast<const struct bech32_address_set_group *>(bytes + sizeof header);
+	for (size_t g = 0; g < header.n_groups; ++g) {
+		const auto &group = groups[g];
+		uint64_t n_records;
+		if (group.hrp_offset > n_data || group.n_hrp > n_data - group.hrp_offset || group.offset > n_data ||
+				group.n_program == 0 || __builtin_mul_overflow(group.n_records, group.n_program, &n_records) ||
+				n_records > n_data - group.offset)
+			return -1;
+	}
+	set->data = bytes, set->n_data = n_data;
+	set->flags = header.flags;
+	set->n_groups = static_cast<size_t>(header.n_groups), set->groups = groups;
+	return 0;
+}
+
+ssize_t bech32_address_set_contains(const struct bech32_address_set *__restrict set, const char *__restrict address, size_t n_address) {
+#ifndef DISABLE_BLECH32
+	if (set->flags & BECH32_ADDRESS_SET_BLECH32)
+		return contains<BlindingAddress, struct blech32_decoder_state>(set, address, n_address);
+#endif
+	return contains<SegwitAddress, struct bech32_decoder_state>(set, address, n_address);
+}
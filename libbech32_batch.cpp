@@ -0,0 +1,386 @@
+#include "bech32_bch.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+using namespace bech32::bch;
+
+
+namespace {
+
+
+// A small work-stealing thread pool. Each participant (the calling thread is participant 0) owns a contiguous range of task
+// indices, which it consumes from the front. A participant that runs out of work steals the back half of another
+// participant's range. The pool is built directly on POSIX threads rather than on <thread> so that the library's core does
+// not depend on the C++ runtime.
+class Pool {
+
+public:
+	static constexpr unsigned MAX_THREADS = 16;
+
+private:
+	// [0, 32) is the index of the next task; [32, 64) is the index past the last task.
+	struct alignas(64) Range {
+		std::atomic<uint_least64_t> bounds;
+	};
+
+private:
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wzero-as-null-pointer-constant" // glibc's initializer macros
+	pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER; // held by the thread that owns the pool for the current job
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER; // guards the fields below it
+	pthread_cond_t wake = PTHREAD_COND_INITIALIZER, done = PTHREAD_COND_INITIALIZER;
+#pragma GCC diagnostic pop
+	unsigned n_threads = 0, n_busy = 0;
+	unsigned long generation = 0;
+	void (*task)(void *, size_t) = nullptr;
+	void *arg = nullptr;
+	Range ranges[MAX_THREADS];
+
+public:
+	constexpr Pool() noexcept : ranges() { }
+
+	void start() noexcept;
+
+	bool try_run(void (*task)(void *, size_t), void *arg, size_t n_tasks) noexcept;
+
+	void reset_after_fork() noexcept { n_threads = 0; }
+
+private:
+	static void * worker_main(void *arg) noexcept;
+
+	static uint_least64_t pack(uint_least64_t begin, uint_least64_t end) noexcept { return end << 32 | begin; }
+
+	void work(unsigned self) noexcept;
+
+	bool steal(unsigned self) noexcept;
+
+};
+
+constinit Pool pool;
+pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+void Pool::start() noexcept {
+	long n_cpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+	if (n_cpus <= 1)
+		return;
+	// block all signals in the workers so that they are delivered only to the application's own threads
+	sigset_t all, saved;
+	::sigfillset(&all);
+	if (::pthread_sigmask(SIG_SETMASK, &all, &saved) != 0)
+		return;
+	pthread_attr_t attr;
+	if (::pthread_attr_init(&attr) == 0) {
+		::pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+		unsigned n_workers = static_cast<unsigned>(n_cpus < MAX_THREADS ? n_cpus : MAX_THREADS) - 1;
+		for (uintptr_t i = 1; i <= n_workers; ++i) {
+			pthread_t thread;
+			if (::pthread_create(&thread, &attr, &worker_main, reinterpret_cast<void *>(i)) != 0)
+				break;
+			n_threads = static_cast<unsigned>(i);
+		}
+		::pthread_attr_destroy(&attr);
+	}
+	::pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+	// the workers would not exist in a forked child, so a child runs its batches on the calling thread
+	::pthread_atfork(nullptr, nullptr, [] { pool.reset_after_fork(); });
+}
+
+bool Pool::try_run(void (*task)(void *, size_t), void *arg, size_t n_tasks) noexcept {
+	if (::pthread_mutex_trylock(&job_mutex) != 0)
+		return false;
+	unsigned n_participants = n_threads + 1;
+	if (n_participants == 1) {
+		::pthread_mutex_unlock(&job_mutex);
+		return false;
+	}
+	for (unsigned i = 0; i < n_participants; ++i)
+		ranges[i].bounds.store(pack(n_tasks * i / n_participants, n_tasks * (i + 1) / n_participants), std::memory_order_relaxed);
+	::pthread_mutex_lock(&mutex);
+	this->task = task, this->arg = arg;
+	n_busy = n_threads;
+	++generation;
+	::pthread_cond_broadcast(&wake);
+	::pthread_mutex_unlock(&mutex);
+	this->work(0);
+	::pthread_mutex_lock(&mutex);
+	while (n_busy)
+		::pthread_cond_wait(&done, &mutex);
+	::pthread_mutex_unlock(&mutex);
+	::pthread_mutex_unlock(&job_mutex);
+	return true;
+}
+
+void * Pool::worker_main(void *arg) noexcept {
+	auto self = static_cast<unsigned>(reinterpret_cast<uintptr_t>(arg));
+	unsigned long seen = 0;
+	for (;;) {
+		::pthread_mutex_lock(&pool.mutex);
+		while (pool.generation == seen)
+			::pthread_cond_wait(&pool.wake, &pool.mutex);
+		seen = pool.generation;
+		::pthread_mutex_unlock(&pool.mutex);
+		pool.work(self);
+		::pthread_mutex_lock(&pool.mutex);
+		if (--pool.n_busy == 0)
+			::pthread_cond_signal(&pool.done);
+		::pthread_mutex_unlock(&pool.mutex);
+	}
+}
+
+void Pool::work(unsigned self) noexcept {
+	auto &bounds = ranges[self].bounds;
+	do {
+		auto cur = bounds.load(std::memory_order_acquire);
+		for (;;) {
+			uint_least64_t begin = cur & UINT32_MAX, end = cur >> 32;
+			if (begin >= end)
+				break;
+			if (bounds.compare_exchange_weak(cur, pack(begin + 1, end), std::memory_order_acq_rel, std::memory_order_acquire))
+				(*task)(arg, begin), cur = bounds.load(std::memory_order_acquire);
+		}
+	} while (this->steal(self));
+}
+
+bool Pool::steal(unsigned self) noexcept {
+	for (unsigned n_participants = n_threads + 1, i = 1; i < n_participants; ++i) {
+		auto &victim = ranges[(self + i) % n_participants].bounds;
+		auto cur = victim.load(std::memory_order_acquire);
+		for (;;) {
+			uint_least64_t begin = cur & UINT32_MAX, end = cur >> 32;
+			if (begin >= end || end - begin < 2)
+				break;
+			uint_least64_t mid = begin + (end - begin) / 2;
+			if (victim.compare_exchange_weak(cur, pack(begin, mid), std::memory_order_acq_rel, std::memory_order_acquire)) {
+				// no one else modifies an empty range, so a plain store suffices
+				ranges[self].bounds.store(pack(mid, end), std::memory_order_release);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+
+struct NoContext { };
+
+template <typename Item, typename Context, void Func(Item &, size_t, const Context &)>
+struct Batch {
+	Item *items;
+	size_t n_items, chunk_size;
+	const Context &context;
+
+	static void run_chunk(void *arg, size_t i) noexcept {
+		auto &batch = *static_cast<Batch *>(arg);
+		size_t k = i * batch.chunk_size, end = batch.n_items - k > batch.chunk_size ? k + batch.chunk_size : batch.n_items;
+		for (; k < end; ++k)
+			Func(batch.items[k], k, batch.context);
+	}
+
+	void run(const struct bech32_executor *executor) noexcept {
+		// chunks are numbered with 32-bit indices in the pool's ranges
+		if ((n_items - 1) / chunk_size > UINT32_MAX)
+			chunk_size = (n_items - 1) / UINT32_MAX + 1;
+		size_t n_chunks = (n_items - 1) / chunk_size + 1;
+		if (executor) {
+			(*executor->run)(executor->ctx, &run_chunk, this, n_chunks);
+			return;
+		}
+		::pthread_once(&pool_once, [] { pool.start(); });
+		if (!pool.try_run(&run_chunk, this, n_chunks))
+			for (size_t i = 0; i < n_chunks; ++i)
+				run_chunk(this, i);
+	}
+};
+
+template <typename Item, typename Context, void Func(Item &, size_t, const Context &)>
+void run_batch(Item items[], size_t n_items, const Context &context, const struct bech32_executor *executor) noexcept {
+	if (n_items < BECH32_BATCH_THRESHOLD) {
+		for (size_t i = 0; i < n_items; ++i)
+			Func(items[i], i, context);
+		return;
+	}
+	Batch<Item, Context, Func> { items, n_items, BECH32_BATCH_CHUNK_SIZE, context }.run(executor);
+}
+
+template <typename Address, typename EncoderState>
+void encode_item(struct bech32_address_encode_item &item, size_t, const NoContext &) noexcept {
+	item.ret = Address::template encode<EncoderState>(item.address, item.n_address, item.program, item.n_program, item.hrp, item.n_hrp, item.version);
+}
+
+template <typename Address, typename DecoderState>
+void decode_item(struct bech32_address_decode_item &item, size_t, const NoContext &) noexcept {
+	item.ret = Address::template decode<DecoderState>(item.program, item.n_program, item.address, item.n_address, &item.n_hrp, &item.version);
+}
+
+
+// SplitMix64, which is fast and of ample quality for test data. Every address takes its draws from its own stretch of the
+// generator's sequence, so that it depends only on its index.
+class Random {
+	uint64_t state;
+
+public:
+	static constexpr uint64_t GAMMA = UINT64_C(0x9e3779b97f4a7c15);
+
+	// the most draws that any address takes
+	static constexpr uint64_t DRAWS_PER_ADDRESS = 32;
+
+	Random(uint64_t seed, uint64_t index) noexcept : state(seed + index * DRAWS_PER_ADDRESS * GAMMA) { }
+
+	uint64_t operator()() noexcept {
+		uint64_t z = state += GAMMA;
+		z = (z ^ z >> 30) * UINT64_C(0xbf58476d1ce4e5b9);
+		z = (z ^ z >> 27) * UINT64_C(0x94d049bb133111eb);
+		return z ^ z >> 31;
+	}
+
+	// Returns a number in [0, n) with negligible bias.
+	uint32_t below(uint32_t n) noexcept {
+		return static_cast<uint32_t>(((*this)() >> 32) * n >> 32);
+	}
+};
+
+// Returns the position of the k-th (zero-based) set bit of a mask that has more than k bits set.
+inline unsigned __attribute__ ((__const__)) nth_bit(uint32_t mask, uint32_t k) noexcept {
+	while (k--)
+		mask &= mask - 1;
+	return static_cast<unsigned>(__builtin_ctz(mask));
+}
+
+inline bool __attribute__ ((__const__)) is_letter(char c) noexcept {
+	return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+struct GenerateContext {
+	const struct bech32_generate_params &params;
+	uint64_t index;
+	uint64_t invalid_threshold; // an address is made invalid iff a draw is less than this
+	bool always_invalid;
+	uint32_t versions, faults;
+};
+
+// Returns the fault injected into the given address, which is in a single case, or BECH32_GENERATE_VALID if none of the
+// allowed faults can be injected.
+enum bech32_generate_fault inject_fault(char *address, size_t n_address, size_t n_hrp, uint32_t faults, Random &random) noexcept {
+	auto fault = static_cast<enum bech32_generate_fault>(1u << nth_bit(faults, random.below(static_cast<uint32_t>(__builtin_popcount(faults)))));
+	bool upper = address[0] >= 'A' && address[0] <= 'Z';
+	size_t data = n_hrp + 1/*separator*/, pos = data + random.below(static_cast<uint32_t>(n_address - data));
+	if (fault == BECH32_GENERATE_MIXED_CASE) {
+		// flip a letter, which must not be the only one, lest the whole address merely change case
+		size_t n_letters = 0;
+		for (size_t i = 0; i < n_address; ++i)
+			n_letters += is_letter(address[i]);
+		if (n_letters >= 2) {
+			for (pos = random.below(static_cast<uint32_t>(n_address)); !is_letter(address[pos]); pos = (pos + 1) % n_address)
+				;
+			address[pos] ^= 0x20;
+			return fault;
+		}
+		// choose among the other allowed faults instead, if there are any
+		if (!(faults &= ~static_cast<uint32_t>(BECH32_GENERATE_MIXED_CASE)))
+			return BECH32_GENERATE_VALID;
+		fault = static_cast<enum bech32_generate_fault>(1u << nth_bit(faults, random.below(static_cast<uint32_t>(__builtin_popcount(faults)))));
+	}
+	char c;
+	if (fault == BECH32_GENERATE_ILLEGAL_CHAR)
+		c = "bio"[random.below(3)];
+	else {
+		// a single substitution is always detected by the checksum
+		int v = DECODE[(address[pos] | 0x20) - '0'];
+		c = ENCODE[(static_cast<unsigned>(v) + 1 + random.below(31)) % 32];
+	}
+	address[pos] = upper && c >= 'a' ? static_cast<char>(c ^ 0x20) : c;
+	return fault;
+}
+
+template <typename Address, typename EncoderState>
+void generate_item(struct bech32_generate_item &item, size_t i, const GenerateContext &context) noexcept {
+	const auto &params = context.params;
+	Random random(params.seed, context.index + i);
+	const char *hrp = params.hrps[random.below(static_cast<uint32_t>(params.n_hrps))];
+	unsigned version = nth_bit(context.versions, random.below(static_cast<uint32_t>(__builtin_popcount(context.versions))));
+	size_t n_program;
+	switch (version) {
+		case 0:
+			n_program = random() & 1 ? Address::PROGRAM_SH_SIZE : Address::PROGRAM_PKH_SIZE;
+			break;
+		case 1:
+			n_program = Address::PROGRAM_SH_SIZE; // P2TR programs are the same size as P2WSH programs
+			break;
+		default: {
+			// any legal size of witness program, plus the blinding key, if any
+			constexpr size_t n_key = Address::PROGRAM_PKH_SIZE - WITNESS_PROGRAM_PKH_SIZE;
+			n_program = n_key + WITNESS_PROGRAM_MIN_SIZE + random.below(WITNESS_PROGRAM_MAX_SIZE - WITNESS_PROGRAM_MIN_SIZE + 1);
+		}
+	}
+	unsigned char program[Address::PROGRAM_MAX_SIZE];
+	for (size_t j = 0; j < n_program; j += sizeof(uint64_t)) {
+		uint64_t r = random();
+		for (size_t k = j; k < n_program && k < j + sizeof(uint64_t); ++k, r >>= CHAR_BIT)
+			program[k] = static_cast<unsigned char>(r);
+	}
+	size_t n_hrp = ::strlen(hrp);
+	item.fault = BECH32_GENERATE_VALID;
+	// most addresses are of the common sizes, which have unrolled encoders
+	if (n_program == Address::PROGRAM_PKH_SIZE)
+		item.ret = FixedAddress<Address, Address::PROGRAM_PKH_SIZE>::template encode<EncoderState>(item.address, item.n_address, program, hrp, n_hrp, version);
+	else if (n_program == Address::PROGRAM_SH_SIZE)
+		item.ret = FixedAddress<Address, Address::PROGRAM_SH_SIZE>::template encode<EncoderState>(item.address, item.n_address, program, hrp, n_hrp, version);
+	else
+		item.ret = Address::template encode<EncoderState>(item.address, item.n_address, program, n_program, hrp, n_hrp, version);
+	if (item.ret < 0)
+		return;
+	auto n_address = static_cast<size_t>(item.ret);
+	if (params.flags & BECH32_GENERATE_UPPERCASE && random() & 1)
+		for (size_t j = 0; j < n_address; ++j)
+			if (item.address[j] >= 'a' && item.address[j] <= 'z')
+				item.address[j] ^= 0x20;
+	if (context.always_invalid || random() < context.invalid_threshold)
+		item.fault = inject_fault(item.address, n_address, n_hrp, context.faults, random);
+}
+
+
+} // namespace
+
+
+void bech32_address_encode_batch(struct bech32_address_encode_item *__restrict items, size_t n_items, const struct bech32_executor *__restrict executor) {
+	run_batch<struct bech32_address_encode_item, NoContext, encode_item<SegwitAddress, struct bech32_encoder_state>>(items, n_items, { }, executor);
+}
+
+void bech32_address_decode_batch(struct bech32_address_decode_item *__restrict items, size_t n_items, const struct bech32_executor *__restrict executor) {
+	run_batch<struct bech32_address_decode_item, NoContext, decode_item<SegwitAddress, struct bech32_decoder_state>>(items, n_items, { }, executor);
+}
+
+void bech32_generate(struct bech32_generate_item *__restrict items, size_t n_items, uint64_t index, const struct bech32_generate_params *__restrict params, const struct bech32_executor *__restrict executor) {
+	constexpr uint32_t ALL_FAULTS = BECH32_GENERATE_BAD_CHECKSUM | BECH32_GENERATE_MIXED_CASE | BECH32_GENERATE_ILLEGAL_CHAR;
+	GenerateContext context {
+		*params, index,
+		// the largest double less than 1 scales to less than 2^64, so only 1 itself needs special treatment
+		params->invalid > 0 && params->invalid < 1 ? static_cast<uint64_t>(params->invalid * 0x1p64) : 0, params->invalid >= 1,
+		params->versions ? params->versions : 0x3, params->faults & ALL_FAULTS ? params->faults & ALL_FAULTS : ALL_FAULTS
+	};
+#ifndef DISABLE_BLECH32
+	if (params->flags & BECH32_GENERATE_BLECH32) {
+		run_batch<struct bech32_generate_item, GenerateContext, generate_item<BlindingAddress, struct blech32_encoder_state>>(items, n_items, context, executor);
+		return;
+	}
+#endif
+	run_batch<struct bech32_generate_item, GenerateContext, generate_item<SegwitAddress, struct bech32_encoder_state>>(items, n_items, context, executor);
+}
+
+
+#ifndef DISABLE_BLECH32
+
+void blech32_address_encode_batch(struct bech32_address_encode_item *__restrict items, size_t n_items, const struct bech32_executor *__restrict executor) {
+	run_batch<struct bech32_address_encode_item, NoContext, encode_item<BlindingAddress, struct blech32_encoder_state>>(items, n_items, { }, executor);
+}
+
+void blech32_address_decode_batch(struct bech32_address_decode_item *__restrict items, size_t n_items, const struct bech32_executor *__restrict executor) {
+	run_batch<struct bech32_address_decode_item, NoContext, decode_item<BlindingAddress, struct blech32_decoder_state>>(items, n_items, { }, executor);
+}
+
+#endif // !defined(DISABLE_BLECH32)
@@ -1,22 +1,17 @@
-#ifdef INCLUDED_FOR_BLECH32
-#	define BECH32_CHECKSUM_SIZE BLECH32_CHECKSUM_SIZE
-#else
-#	ifndef DISABLE_BLECH32
-#		define INCLUDED_FOR_BLECH32
-#		include "libbech32_c++.cpp"
-#		undef INCLUDED_FOR_BLECH32
-#		undef BECH32_H_INCLUDED
-#		define DISABLE_BLECH32
-#		define BECH32_H_SECOND_PASS
-#		define LIBBECH32_CXX_CPP_SECOND_PASS
-#	endif
-#	undef BECH32_CHECKSUM_SIZE
-#endif
-
-#include "bech32.h"
-
-
-#ifndef LIBBECH32_CXX_CPP_SECOND_PASS
+#include "bech32_bch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <ostream>
+#include <shared_mutex>
+#include <system_error>
+
+#include <unistd.h>
+
+
 static inline const char * __attribute__ ((__const__)) error_to_message(enum ::bech32_error error) {
 	switch (error) {
 		case BECH32_TOO_SHORT:
@@ -52,10 +47,8 @@ static inline const char * __attribute__ ((__const__)) error_to_message(enum ::b
 	}
 	std::abort(); // should not be reachable
 }
-#endif
 
 
-#ifndef LIBBECH32_CXX_CPP_SECOND_PASS
 namespace bech32 {
 
 
@@ -63,56 +56,574 @@ Error::Error(enum ::bech32_error error) : std::runtime_error(::error_to_message(
 }
 
 
-} // namespace bech32
-#endif // !defined(LIBBECH32_CXX_CPP_SECOND_PASS)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsuggest-attribute=const" // building a function object that merely captures the argument
+std::function<void (std::string_view)> ostream_sink(std::ostream &os) {
+	return [&os](std::string_view block) {
+		os.write(block.data(), static_cast<std::streamsize>(block.size()));
+	};
+}
 
+std::function<void (std::string_view)> fd_sink(int fd) {
+	return [fd](std::string_view block) {
+		while (!block.empty())
+			if (ssize_t n = ::write(fd, block.data(), block.size()); n >= 0)
+				block.remove_prefix(static_cast<size_t>(n));
+			else if (errno != EINTR)
+				throw std::system_error(errno, std::generic_category(), "write");
+	};
+}
+#pragma GCC diagnostic pop
 
-#ifdef INCLUDED_FOR_BLECH32
-using namespace bech32;
-#	define bech32 blech32
-#endif
-namespace bech32 {
 
+static inline unsigned __attribute__ ((__pure__)) symbol(char c) noexcept {
+	return bch::DECODE_FLAGS[static_cast<unsigned char>(c)] & 0x1F;
+}
 
-void Encoder::reset(std::string_view hrp, size_t nbits_reserve) {
+uint_least64_t BitSpan::value() const {
+	if (in.size() > 64 / 5)
+		throw Error(BECH32_TOO_LONG);
+	uint_least64_t value = 0;
+	for (char c : in)
+		value = value << 5 | symbol(c);
+	return value;
+}
+
+void BitSpan::read(void *out, size_t nbits_out) const {
+	if (nbits_out > this->size())
+		throw Error(BECH32_TOO_SHORT);
+	auto p = static_cast<unsigned char *>(out);
+	uint_fast32_t bits = 0;
+	size_t nbits = 0;
+	for (const char *q = in.data(); nbits_out;) {
+		size_t n = nbits_out > CHAR_BIT ? CHAR_BIT : nbits_out;
+		for (; nbits < n; nbits += 5)
+			bits = bits << 5 | symbol(*q++);
+		*p++ = static_cast<unsigned char>(bits >> (nbits -= n) & (1 << n) - 1), nbits_out -= n;
+	}
+}
+
+std::vector<std::byte> BitSpan::bytes() const {
+	std::vector<std::byte> out(this->size() / CHAR_BIT);
+	this->read(out.data(), out.size() * CHAR_BIT);
+	return out;
+}
+
+
+TaggedFields::TaggedFields(std::string_view in) : in(in) {
+	for (size_t i = 0; i < in.size();)
+		if (in.size() - i < 3/*header*/ || in.size() - i - 3/*header*/ < field(in.data() + i).length)
+			throw Error(BECH32_TOO_SHORT);
+		else
+			i += 3/*header*/ + field(in.data() + i).length;
+}
+
+TaggedField TaggedFields::field(const char *in) noexcept {
+	size_t length = symbol(in[1]) << 5 | symbol(in[2]);
+	return { symbol(in[0]), length, BitSpan({ in + 3/*header*/, length }) };
+}
+
+
+} // namespace bech32
+
+
+template <typename BCH, typename State>
+static void encoder_reset(State &state, std::string &out, std::string_view hrp, size_t nbits_reserve) {
 	out.clear();
-	out.resize(::bech32_encoded_size(hrp.size(), nbits_reserve, 0));
-	if (auto error = ::bech32_encode_begin(&state, out.data(), out.size(), hrp.data(), hrp.size()))
-		throw Error(error);
+	out.resize(BCH::encoded_size(hrp.size(), nbits_reserve, 0));
+	if (auto error = BCH::encode_begin(&state, out.data(), out.size(), hrp.data(), hrp.size()))
+		throw bech32::Error(error);
 	out.resize(state.out - out.data());
 }
 
-void Encoder::write(const void *in, size_t nbits_in) {
+template <typename BCH, typename State>
+static void encoder_write(State &state, std::string &out, const void *in, size_t nbits_in) {
 	size_t written = out.size();
-	out.resize(written + (state.n_out = ::bech32_encoded_size(0, state.nbits + nbits_in, 0) - 1));
+	out.resize(written + (state.n_out = BCH::encoded_size(0, state.nbits + nbits_in, 0) - 1));
 	state.out = out.data() + written;
-	if (auto error = ::bech32_encode_data(&state, static_cast<const unsigned char *>(in), nbits_in))
-		throw Error(error);
+	if (auto error = BCH::encode_data(&state, static_cast<const unsigned char *>(in), nbits_in))
+		throw bech32::Error(error);
 	out.resize(state.out - out.data());
 }
 
-std::string Encoder::finish(bech32_constant_t constant) {
+template <typename BCH, typename State>
+static std::string encoder_finish(State &state, std::string &out, typename BCH::checksum_t constant) {
 	size_t written = out.size();
-	out.resize(written + (state.n_out = ::bech32_encoded_size(0, state.nbits, 0) - 1));
+	out.resize(written + (state.n_out = BCH::encoded_size(0, state.nbits, 0) - 1));
 	state.out = out.data() + written;
-	if (auto error = ::bech32_encode_finish(&state, constant))
-		throw Error(error);
+	if (auto error = BCH::encode_finish(&state, constant))
+		throw bech32::Error(error);
 	out.resize(state.out - out.data());
 	state = { };
 	return std::move(out);
 }
 
 
-void Decoder::reset(std::string_view in) {
-	if (auto ret = ::bech32_decode_begin(&state, in.data(), in.size()); ret < 0)
-		throw Error(static_cast<enum ::bech32_error>(ret));
+template <typename State, size_t N>
+static void stream_encoder_flush(State &state, std::array<char, N> &block, const bech32::Sink &sink) {
+	if (size_t n = state.out - block.data()) {
+		sink({ block.data(), n });
+		state.out = block.data(), state.n_out = N;
+	}
+}
+
+template <typename BCH, typename State, size_t N>
+static void stream_encoder_reset(State &state, std::array<char, N> &block, std::string_view hrp) {
+	static_assert(N >= BCH::MAX_SIZE, "block must hold the longest human-readable prefix");
+	if (auto error = BCH::encode_begin(&state, block.data(), N, hrp.data(), hrp.size()))
+		throw bech32::Error(error);
+}
+
+template <typename BCH, typename State, size_t N>
+static void stream_encoder_write(State &state, std::array<char, N> &block, const bech32::Sink &sink, const void *in, size_t nbits_in) {
+	for (auto p = static_cast<const unsigned char *>(in); nbits_in;) {
+		// feed as many whole bytes as will fit in the block, or all that remain
+		size_t nbits = state.n_out * 5 > state.nbits ? (state.n_out * 5 - state.nbits) / CHAR_BIT * CHAR_BIT : 0;
+		if (nbits > nbits_in)
+			nbits = nbits_in;
+		else if (!nbits) {
+			stream_encoder_flush(state, block, sink);
+			continue;
+		}
+		if (auto error = BCH::encode_data(&state, p, nbits))
+			throw bech32::Error(error);
+		p += nbits / CHAR_BIT, nbits_in -= nbits;
+	}
+}
+
+template <typename BCH, typename State, size_t N>
+static void stream_encoder_finish(State &state, std::array<char, N> &block, const bech32::Sink &sink, typename BCH::checksum_t constant) {
+	if (state.n_out < 1 + BCH::CHECKSUM_SIZE)
+		stream_encoder_flush(state, block, sink);
+	if (auto error = BCH::encode_finish(&state, constant))
+		throw bech32::Error(error);
+	stream_encoder_flush(state, block, sink);
+	state = { };
+}
+
+
+template <typename BCH, typename State>
+static std::string_view decoder_reset(State &state, std::string_view in, size_t n_max) {
+	if (auto ret = BCH::decode_begin(&state, in.data(), in.size(), n_max); ret < 0)
+		throw bech32::Error(static_cast<enum ::bech32_error>(ret));
+	else
+		return in.substr(0, static_cast<size_t>(ret));
+}
+
+template <typename BCH, typename State>
+static void decoder_read(State &state, void *out, size_t nbits_out) {
+	if (auto error = BCH::decode_data(&state, static_cast<unsigned char *>(out), nbits_out))
+		throw bech32::Error(error);
+}
+
+template <typename BCH, typename State>
+static std::string_view decoder_skip(State &state, size_t n_chars) {
+	const char *in = state.in;
+	if (auto error = BCH::decode_skip(&state, n_chars))
+		throw bech32::Error(error);
+	return { in, n_chars };
+}
+
+template <typename BCH, typename State>
+static bech32::TaggedFields decoder_fields(State &state, size_t nbits_trailer) {
+	size_t n_trailer = (nbits_trailer + 4) / 5;
+	if (state.nbits)
+		throw bech32::Error(BECH32_PADDING_ERROR);
+	if (n_trailer > state.n_in)
+		throw bech32::Error(BECH32_TOO_SHORT);
+	// validate the fields before consuming them so that a failure leaves the decoder as it was
+	bech32::TaggedFields fields({ state.in, state.n_in - n_trailer });
+	decoder_skip<BCH>(state, fields.symbols().size());
+	return fields;
+}
+
+template <typename BCH, typename State>
+static size_t decoder_finish(State &state, typename BCH::checksum_t constant) {
+	if (auto ret = BCH::decode_finish(&state, constant); ret < 0)
+		throw bech32::Error(static_cast<enum ::bech32_error>(ret));
+	else
+		return static_cast<size_t>(ret);
+}
+
+template <typename V0, typename V1, typename State, typename Constant>
+static size_t decoder_finish_detect(State &state, Constant &constant) {
+	typename V0::checksum_t chk;
+	if (auto ret = V0::code_t::decode_finish_detect(&state, &chk, V0::CONSTANT, V1::CONSTANT); ret < 0)
+		throw bech32::Error(static_cast<enum ::bech32_error>(ret));
+	else {
+		constant = static_cast<Constant>(chk);
+		return static_cast<size_t>(ret);
+	}
+}
+
+
+template <typename BCH, typename State>
+static std::vector<std::byte> stream_decoder_write(State &state, std::string_view in) {
+	std::vector<std::byte> out(BCH::stream_decoded_size(&state, in.size()));
+	if (auto ret = BCH::stream_decode_data(&state, reinterpret_cast<unsigned char *>(out.data()), out.size(), in.data(), in.size()); ret < 0)
+		throw bech32::Error(static_cast<enum ::bech32_error>(ret));
 	else
-		hrp = in.substr(0, static_cast<size_t>(ret));
+		out.resize(static_cast<size_t>(ret));
+	return out;
+}
+
+template <typename BCH, typename State>
+static std::vector<std::byte> stream_decoder_finish(State &state, typename BCH::checksum_t constant) {
+	std::vector<std::byte> out(BCH::stream_decoded_size(&state, 0));
+	if (auto ret = BCH::stream_decode_finish(&state, reinterpret_cast<unsigned char *>(out.data()), out.size(), constant); ret < 0)
+		throw bech32::Error(static_cast<enum ::bech32_error>(ret));
+	else
+		out.resize(static_cast<size_t>(ret));
+	return out;
+}
+
+
+template <typename Address, typename EncoderState>
+static std::string encode_address(const void *program, size_t n_program, std::string_view hrp, unsigned version) {
+	std::string address;
+	address.resize(Address::code_t::encoded_size(hrp.size(), 5/*version*/ + n_program * CHAR_BIT, 0));
+	if (auto ret = Address::template encode<EncoderState>(address.data(), address.size() + 1/*null*/, static_cast<const unsigned char *>(program), n_program, hrp.data(), hrp.size(), version); ret < 0)
+		throw bech32::Error(static_cast<enum ::bech32_error>(ret));
+	else
+		address.resize(static_cast<size_t>(ret));
+	return address;
+}
+
+template <typename Address, typename DecoderState>
+static std::tuple<std::vector<std::byte>, std::string_view, unsigned> decode_address(std::string_view address) {
+	std::tuple<std::vector<std::byte>, std::string_view, unsigned> ret;
+	auto &[program, hrp, version] = ret;
+	program.resize((address.size() - 1/*hrp*/ - 1/*separator*/ - Address::code_t::CHECKSUM_SIZE) * 5 / CHAR_BIT);
+	size_t n_hrp;
+	if (auto ret = Address::template decode<DecoderState>(reinterpret_cast<unsigned char *>(program.data()), program.size(), address.data(), address.size(), &n_hrp, &version); ret < 0)
+		throw bech32::Error(static_cast<enum ::bech32_error>(ret));
+	else
+		program.resize(static_cast<size_t>(ret));
+	hrp = address.substr(0, n_hrp);
+	return ret;
+}
+
+
+// The checksum characters at the end of an address serve as its key in an AddressSet. Fails if any of them is not a valid
+// data character, since then the address cannot be valid.
+template <typename Address, typename Key>
+static inline bool address_set_key(std::string_view address, Key &key) noexcept {
+	constexpr size_t n = Address::code_t::CHECKSUM_SIZE;
+	if (address.size() < n)
+		return false;
+	key = 0;
+	for (char c : address.substr(address.size() - n)) {
+		int_fast32_t v = static_cast<int_fast32_t>(c) - '0';
+		if (v < 0 || v > 'z' - '0' || (v = bech32::bch::DECODE[v]) < 0)
+			return false;
+		key = static_cast<Key>(key << 5 | v);
+	}
+	return true;
+}
+
+template <typename Address>
+struct address_set_probe {
+	unsigned char program[Address::PROGRAM_MAX_SIZE];
+	ssize_t n_program = 0;
+	size_t n_hrp;
+	unsigned version;
+	std::string_view address;
+
+	explicit address_set_probe(std::string_view address) noexcept : address(address) { }
+
+	// Decodes the address on first use. Returns false if the address is invalid.
+	template <typename DecoderState>
+	bool decode() noexcept {
+		if (!n_program)
+			n_program = Address::template decode<DecoderState>(program, sizeof program, address.data(), address.size(), &n_hrp, &version);
+		return n_program > 0;
+	}
+
+	template <typename Entry>
+	bool __attribute__ ((__pure__)) matches(const Entry &entry, const std::vector<unsigned char> &data) const noexcept {
+		if (entry.version != version || entry.n_program != static_cast<size_t>(n_program) || entry.n_hrp != n_hrp)
+			return false;
+		const unsigned char *p = data.data() + entry.offset;
+		for (size_t i = 0; i < n_hrp; ++i)
+			if (p[i] != (address[i] >= 'A' && address[i] <= 'Z' ? address[i] | 0x20 : address[i]))
+				return false;
+		return std::memcmp(p + n_hrp, program, entry.n_program) == 0;
+	}
+};
+
+template <typename Slot>
+static void address_set_rehash(std::vector<Slot> &slots, size_t n_slots) {
+	std::vector<Slot> rehashed(n_slots);
+	for (size_t mask = n_slots - 1; const auto &slot : slots)
+		if (slot.index) {
+			size_t i = static_cast<size_t>(slot.key) & mask;
+			while (rehashed[i].index)
+				i = i + 1 & mask;
+			rehashed[i] = slot;
+		}
+	slots = std::move(rehashed);
+}
+
+template <typename Slot>
+static void address_set_reserve(std::vector<Slot> &slots, size_t n) {
+	// keep the load factor at or below one half so that linear probes stay short
+	if (n > SIZE_MAX / 4)
+		throw std::length_error("AddressSet");
+	size_t n_slots = 16;
+	while (n_slots < n * 2)
+		n_slots *= 2;
+	if (n_slots > slots.size())
+		address_set_rehash(slots, n_slots);
+}
+
+template <typename Address, typename DecoderState, typename Slot, typename Entry>
+static bool address_set_insert(std::vector<Slot> &slots, std::vector<Entry> &entries, std::vector<unsigned char> &data, std::string_view address) {
+	address_set_probe<Address> probe(address);
+	if (!probe.template decode<DecoderState>())
+		throw bech32::Error(static_cast<enum ::bech32_error>(probe.n_program));
+	decltype(Slot::key) key = 0;
+	address_set_key<Address>(address, key);
+	if (entries.size() >= UINT_LEAST32_MAX - 1)
+		throw std::length_error("AddressSet");
+	if ((entries.size() + 1) * 2 > slots.size())
+		address_set_reserve(slots, entries.size() + 1);
+	size_t mask = slots.size() - 1, i = static_cast<size_t>(key) & mask;
+	for (; slots[i].index; i = i + 1 & mask)
+		if (slots[i].key == key && probe.matches(entries[slots[i].index - 1], data))
+			return false;
+	Entry entry { data.size(), static_cast<uint_least16_t>(probe.n_hrp), static_cast<uint_least8_t>(probe.n_program), static_cast<uint_least8_t>(probe.version) };
+	for (size_t j = 0; j < probe.n_hrp; ++j)
+		data.push_back(static_cast<unsigned char>(address[j] >= 'A' && address[j] <= 'Z' ? address[j] | 0x20 : address[j]));
+	data.insert(data.end(), probe.program, probe.program + probe.n_program);
+	entries.push_back(entry);
+	slots[i] = { key, static_cast<uint_least32_t>(entries.size()) };
+	return true;
+}
+
+template <typename Address, typename DecoderState, typename Slot, typename Entry>
+static bool __attribute__ ((__pure__)) address_set_contains(const std::vector<Slot> &slots, const std::vector<Entry> &entries, const std::vector<unsigned char> &data, std::string_view address, decltype(Slot::key) key) noexcept {
+	address_set_probe<Address> probe(address);
+	for (size_t mask = slots.size() - 1, i = static_cast<size_t>(key) & mask; slots[i].index; i = i + 1 & mask)
+		if (slots[i].key == key) {
+			if (!probe.template decode<DecoderState>())
+				return false;
+			if (probe.matches(entries[slots[i].index - 1], data))
+				return true;
+		}
+	return false;
+}
+
+template <typename Address, typename DecoderState, typename Slot, typename Entry>
+static size_t address_set_contains(const std::vector<Slot> &slots, const std::vector<Entry> &entries, const std::vector<unsigned char> &data, std::span<const std::string_view> addresses, bool results[]) noexcept {
+	// compute keys and prefetch their slots a few addresses ahead of the probes
+	constexpr size_t AHEAD = 8;
+	decltype(Slot::key) keys[AHEAD];
+	bool valid[AHEAD];
+	size_t n_addresses = addresses.size(), n_members = 0;
+	if (slots.empty()) {
+		std::fill_n(results, n_addresses, false);
+		return 0;
+	}
+	size_t mask = slots.size() - 1;
+	auto fetch = [&](size_t i) noexcept {
+		if ((valid[i % AHEAD] = address_set_key<Address>(addresses[i], keys[i % AHEAD])))
+			__builtin_prefetch(&slots[static_cast<size_t>(keys[i % AHEAD]) & mask]);
+	};
+	for (size_t i = 0; i < AHEAD && i < n_addresses; ++i)
+		fetch(i);
+	for (size_t i = 0; i < n_addresses; ++i) {
+		bool member = valid[i % AHEAD] && address_set_contains<Address, DecoderState>(slots, entries, data, addresses[i], keys[i % AHEAD]);
+		n_members += results[i] = member;
+		if (i + AHEAD < n_addresses)
+			fetch(i + AHEAD);
+	}
+	return n_members;
+}
+
+
+// A shard of a DecodeCache. Its entries are replaced in CLOCK order and are indexed by an open-addressed hash table keyed, as
+// in an AddressSet, by the checksum characters of each address. A lookup holds the lock shared and marks the entry it hits
+// with a relaxed store, so concurrent lookups do not serialize; only an insertion holds the lock exclusively.
+template <typename Address>
+struct alignas(64) decode_cache_shard {
+	using key_t = typename Address::code_t::checksum_t;
+
+	struct Entry {
+		std::string address;
+		key_t key;
+		mutable std::atomic<bool> referenced;
+		uint_least16_t n_hrp;
+		uint_least8_t n_program, version;
+		unsigned char program[Address::PROGRAM_MAX_SIZE];
+	};
+
+	mutable std::shared_mutex mutex;
+	std::unique_ptr<Entry[]> entries;
+	std::vector<uint_least32_t> slots; // one more than the index of an entry, or zero if the slot is empty
+	size_t capacity = 0, n_entries = 0, hand = 0;
+	std::atomic<uint_least64_t> hits { 0 }, misses { 0 };
+
+	static size_t __attribute__ ((__const__)) home(key_t key, size_t mask) noexcept {
+		// the low bits of the key select the shard
+		return static_cast<size_t>(key) / bech32::DecodeCache::SHARDS & mask;
+	}
+
+	void reserve(size_t capacity) {
+		// keep the load factor at or below one half so that linear probes stay short
+		if (capacity >= UINT_LEAST32_MAX / 2)
+			throw std::length_error("DecodeCache");
+		size_t n_slots = 2;
+		while (n_slots < capacity * 2)
+			n_slots *= 2;
+		entries = std::make_unique<Entry[]>(capacity), slots.assign(n_slots, 0);
+		this->capacity = capacity;
+	}
+
+	size_t size() const noexcept {
+		std::shared_lock lock(mutex);
+		return n_entries;
+	}
+
+	void clear() noexcept {
+		std::unique_lock lock(mutex);
+		std::fill(slots.begin(), slots.end(), 0);
+		n_entries = 0, hand = 0;
+		hits.store(0, std::memory_order_relaxed), misses.store(0, std::memory_order_relaxed);
+	}
+
+	// Returns the position of the slot that indexes the given address or, if none does, of the empty slot at which it belongs.
+	size_t __attribute__ ((__pure__)) find(std::string_view address, key_t key) const noexcept {
+		size_t mask = slots.size() - 1, i = home(key, mask);
+		for (; slots[i]; i = i + 1 & mask)
+			if (const Entry &entry = entries[slots[i] - 1]; entry.key == key && entry.address == address)
+				break;
+		return i;
+	}
+
+	// Empties the slot at the given position, shifting back any entries after it that would otherwise become unreachable.
+	void erase(size_t i) noexcept {
+		for (size_t mask = slots.size() - 1, j = i;;) {
+			slots[i] = 0;
+			size_t k;
+			do {
+				if (!slots[j = j + 1 & mask])
+					return;
+				k = home(entries[slots[j] - 1].key, mask);
+				// the entry at j must stay put if its home slot lies cyclically in (i, j]
+			} while (i <= j ? i < k && k <= j : i < k || k <= j);
+			slots[i] = slots[j], i = j;
+		}
+	}
+
+	void insert(std::string_view address, key_t key, const std::tuple<std::vector<std::byte>, std::string_view, unsigned> &decoded) {
+		const auto &[program, hrp, version] = decoded;
+		std::unique_lock lock(mutex);
+		size_t pos = this->find(address, key), index;
+		if (slots[pos])
+			return; // another thread inserted the address while this one was decoding it
+		if (n_entries < capacity)
+			index = n_entries++;
+		else {
+			// advance the hand past the entries that have been hit since it last passed them, unmarking them as it goes
+			while (entries[hand].referenced.exchange(false, std::memory_order_relaxed))
+				hand = (hand + 1) % capacity;
+			index = hand, hand = (hand + 1) % capacity;
+			this->erase(this->find(entries[index].address, entries[index].key));
+			pos = this->find(address, key);
+		}
+		Entry &entry = entries[index];
+		entry.address.assign(address);
+		entry.key = key, entry.referenced.store(false, std::memory_order_relaxed);
+		entry.n_hrp = static_cast<uint_least16_t>(hrp.size());
+		entry.n_program = static_cast<uint_least8_t>(program.size()), entry.version = static_cast<uint_least8_t>(version);
+		std::memcpy(entry.program, program.data(), program.size());
+		slots[pos] = static_cast<uint_least32_t>(index + 1);
+	}
+
+	template <typename DecoderState>
+	std::tuple<std::vector<std::byte>, std::string_view, unsigned> decode(std::string_view address, key_t key) {
+		if (capacity) {
+			std::shared_lock lock(mutex);
+			if (size_t pos = this->find(address, key); slots[pos]) {
+				const Entry &entry = entries[slots[pos] - 1];
+				entry.referenced.store(true, std::memory_order_relaxed);
+				hits.fetch_add(1, std::memory_order_relaxed);
+				auto program = reinterpret_cast<const std::byte *>(entry.program);
+				return { std::vector<std::byte>(program, program + entry.n_program), address.substr(0, entry.n_hrp), entry.version };
+			}
+		}
+		misses.fetch_add(1, std::memory_order_relaxed);
+		// decode outside the lock, as decoding costs far more than a lookup
+		auto ret = decode_address<Address, DecoderState>(address);
+		if (capacity)
+			this->insert(address, key, ret);
+		return ret;
+	}
+};
+
+template <typename Shard>
+static void decode_cache_reserve(std::unique_ptr<Shard[]> &shards, size_t capacity) {
+	shards = std::make_unique<Shard[]>(bech32::DecodeCache::SHARDS);
+	for (size_t i = 0; i < bech32::DecodeCache::SHARDS; ++i)
+		shards[i].reserve(capacity / bech32::DecodeCache::SHARDS + (capacity % bech32::DecodeCache::SHARDS != 0));
+}
+
+template <typename Shard, typename Func>
+static auto decode_cache_sum(const std::unique_ptr<Shard[]> &shards, Func func) noexcept {
+	decltype(func(shards[0])) sum = 0;
+	// a moved-from cache has no shards and acts as an empty cache of no capacity
+	for (size_t i = 0; shards && i < bech32::DecodeCache::SHARDS; ++i)
+		sum += func(shards[i]);
+	return sum;
+}
+
+template <typename Address, typename DecoderState, typename Shard>
+static std::tuple<std::vector<std::byte>, std::string_view, unsigned> decode_cache_decode(std::unique_ptr<Shard[]> &shards, std::string_view address) {
+	typename Shard::key_t key;
+	if (!shards || !address_set_key<Address>(address, key))
+		return decode_address<Address, DecoderState>(address); // throws if the address has no key, since it cannot be valid
+	return shards[static_cast<size_t>(key) % bech32::DecodeCache::SHARDS].template decode<DecoderState>(address, key);
+}
+
+
+namespace bech32 {
+
+
+void Encoder::reset(std::string_view hrp, size_t nbits_reserve) {
+	encoder_reset<bch::Bech32Code>(state, out, hrp, nbits_reserve);
+}
+
+void Encoder::write(const void *in, size_t nbits_in) {
+	encoder_write<bch::Bech32Code>(state, out, in, nbits_in);
+}
+
+std::string Encoder::finish(bech32_constant_t constant) {
+	return encoder_finish<bch::Bech32Code>(state, out, constant);
+}
+
+
+void StreamEncoder::reset(std::string_view hrp) {
+	stream_encoder_reset<bch::Bech32Code>(state, block, hrp);
+}
+
+void StreamEncoder::write(const void *in, size_t nbits_in) {
+	stream_encoder_write<bch::Bech32Code>(state, block, sink, in, nbits_in);
+}
+
+void StreamEncoder::finish(bech32_constant_t constant) {
+	stream_encoder_finish<bch::Bech32Code>(state, block, sink, constant);
+}
+
+void Decoder::reset(std::string_view in) {
+	this->reset(in, bch::Bech32Code::MAX_SIZE);
+}
+
+void Decoder::reset(std::string_view in, size_t n_max) {
+	hrp = decoder_reset<bch::Bech32Code>(state, in, n_max);
 }
 
 void Decoder::read(void *out, size_t nbits_out) {
-	if (auto error = ::bech32_decode_data(&state, static_cast<unsigned char *>(out), nbits_out))
-		throw Error(error);
+	decoder_read<bch::Bech32Code>(state, out, nbits_out);
 }
 
 std::vector<std::byte> Decoder::read(size_t nbits) {
@@ -123,37 +634,290 @@ std::vector<std::byte> Decoder::read(size_t nbits) {
 	return out;
 }
 
+BitSpan Decoder::read_span(size_t nbits) {
+	return BitSpan(decoder_skip<bch::Bech32Code>(state, (nbits + 4) / 5));
+}
+
+TaggedFields Decoder::fields(size_t nbits_trailer) {
+	return decoder_fields<bch::Bech32Code>(state, nbits_trailer);
+}
+
 size_t Decoder::finish(bech32_constant_t constant) {
-	if (auto ret = ::bech32_decode_finish(&state, constant); ret < 0)
-		throw Error(static_cast<enum ::bech32_error>(ret));
-	else
-		return static_cast<size_t>(ret);
+	return decoder_finish<bch::Bech32Code>(state, constant);
+}
+
+size_t Decoder::finish_detect(bech32_constant_t &constant) {
+	return decoder_finish_detect<bch::Bech32, bch::Bech32m>(state, constant);
+}
+
+
+std::vector<std::byte> StreamDecoder::write(std::string_view in) {
+	return stream_decoder_write<bch::Bech32Code>(state, in);
+}
+
+std::vector<std::byte> StreamDecoder::finish(bech32_constant_t constant) {
+	return stream_decoder_finish<bch::Bech32Code>(state, constant);
 }
 
 
 std::string encode_segwit_address(const void *program, size_t n_program, std::string_view hrp, unsigned version) {
+	return encode_address<bch::SegwitAddress, struct ::bech32_encoder_state>(program, n_program, hrp, version);
+}
+
+std::tuple<std::vector<std::byte>, std::string_view, unsigned> decode_segwit_address(std::string_view address) {
+	return decode_address<bch::SegwitAddress, struct ::bech32_decoder_state>(address);
+}
+
+
+template <size_t ProgramSize>
+std::string FixedAddress<ProgramSize>::encode(const program_t &program, std::string_view hrp, unsigned version) {
+	using Fixed = bch::FixedAddress<bch::SegwitAddress, ProgramSize>;
 	std::string address;
-	address.resize(::bech32_encoded_size(hrp.size(), 5/*version*/ + n_program * CHAR_BIT, 0));
-	if (auto ret = ::bech32_address_encode(address.data(), address.size() + 1/*null*/, static_cast<const unsigned char *>(program), n_program, hrp.data(), hrp.size(), version); ret < 0)
+	address.resize(hrp.size() + 1/*separator*/ + Fixed::DATA_SIZE);
+	if (auto ret = Fixed::template encode<struct ::bech32_encoder_state>(address.data(), address.size() + 1/*null*/, reinterpret_cast<const unsigned char *>(program.data()), hrp.data(), hrp.size(), version); ret < 0)
 		throw Error(static_cast<enum ::bech32_error>(ret));
-	else
-		address.resize(static_cast<size_t>(ret));
 	return address;
 }
 
-std::tuple<std::vector<std::byte>, std::string_view, unsigned> decode_segwit_address(std::string_view address) {
-	std::tuple<std::vector<std::byte>, std::string_view, unsigned> ret;
+template <size_t ProgramSize>
+auto FixedAddress<ProgramSize>::decode(std::string_view address) -> std::tuple<program_t, std::string_view, unsigned> {
+	using Fixed = bch::FixedAddress<bch::SegwitAddress, ProgramSize>;
+	std::tuple<program_t, std::string_view, unsigned> ret;
 	auto &[program, hrp, version] = ret;
-	program.resize((address.size() - 1/*hrp*/ - 1/*separator*/ - BECH32_CHECKSUM_SIZE) * 5 / CHAR_BIT);
 	size_t n_hrp;
-	if (auto ret = ::bech32_address_decode(reinterpret_cast<unsigned char *>(program.data()), program.size(), address.data(), address.size(), &n_hrp, &version); ret < 0)
+	if (auto ret = Fixed::template decode<struct ::bech32_decoder_state>(reinterpret_cast<unsigned char *>(program.data()), address.data(), address.size(), &n_hrp, &version); ret < 0)
 		throw Error(static_cast<enum ::bech32_error>(ret));
-	else
-		program.resize(static_cast<size_t>(ret));
 	hrp = address.substr(0, n_hrp);
 	return ret;
 }
 
+template struct FixedAddress<20>;
+template struct FixedAddress<32>;
+
+
+void AddressSet::reserve(size_t n) {
+	address_set_reserve(slots, n);
+}
+
+void AddressSet::clear() noexcept {
+	slots.clear(), entries.clear(), data.clear();
+}
+
+bool AddressSet::insert(std::string_view address) {
+	return address_set_insert<bch::SegwitAddress, struct ::bech32_decoder_state>(slots, entries, data, address);
+}
+
+size_t AddressSet::insert(std::span<const std::string_view> addresses) {
+	this->reserve(entries.size() + addresses.size());
+	size_t n = 0;
+	for (auto address : addresses)
+		n += this->insert(address);
+	return n;
+}
+
+bool AddressSet::contains(std::string_view address) const noexcept {
+	decltype(Slot::key) key;
+	return !slots.empty() && address_set_key<bch::SegwitAddress>(address, key) &&
+			address_set_contains<bch::SegwitAddress, struct ::bech32_decoder_state>(slots, entries, data, address, key);
+}
+
+size_t AddressSet::contains(std::span<const std::string_view> addresses, bool results[]) const noexcept {
+	return address_set_contains<bch::SegwitAddress, struct ::bech32_decoder_state>(slots, entries, data, addresses, results);
+}
+
+
+struct __attribute__ ((__visibility__ ("hidden"))) DecodeCache::Shard : decode_cache_shard<bch::SegwitAddress> { };
+
+DecodeCache::DecodeCache(size_t capacity) {
+	decode_cache_reserve(shards, capacity);
+}
+
+DecodeCache::DecodeCache(DecodeCache &&) noexcept = default;
+
+DecodeCache & DecodeCache::operator=(DecodeCache &&) noexcept = default;
+
+DecodeCache::~DecodeCache() = default;
+
+size_t DecodeCache::capacity() const noexcept {
+	return decode_cache_sum(shards, [](const Shard &shard) noexcept { return shard.capacity; });
+}
+
+size_t DecodeCache::size() const noexcept {
+	return decode_cache_sum(shards, [](const Shard &shard) noexcept { return shard.size(); });
+}
+
+uint_least64_t DecodeCache::hits() const noexcept {
+	return decode_cache_sum(shards, [](const Shard &shard) noexcept { return shard.hits.load(std::memory_order_relaxed); });
+}
+
+uint_least64_t DecodeCache::misses() const noexcept {
+	return decode_cache_sum(shards, [](const Shard &shard) noexcept { return shard.misses.load(std::memory_order_relaxed); });
+}
+
+void DecodeCache::clear() noexcept {
+	for (size_t i = 0; shards && i < SHARDS; ++i)
+		shards[i].clear();
+}
+
+std::tuple<std::vector<std::byte>, std::string_view, unsigned> DecodeCache::decode(std::string_view address) {
+	return decode_cache_decode<bch::SegwitAddress, struct ::bech32_decoder_state>(shards, address);
+}
+
 
 } // namespace bech32
-#undef bech32
+
+#ifndef DISABLE_BLECH32
+namespace blech32 {
+
+
+void Encoder::reset(std::string_view hrp, size_t nbits_reserve) {
+	encoder_reset<bech32::bch::Blech32Code>(state, out, hrp, nbits_reserve);
+}
+
+void Encoder::write(const void *in, size_t nbits_in) {
+	encoder_write<bech32::bch::Blech32Code>(state, out, in, nbits_in);
+}
+
+std::string Encoder::finish(blech32_constant_t constant) {
+	return encoder_finish<bech32::bch::Blech32Code>(state, out, constant);
+}
+
+
+void StreamEncoder::reset(std::string_view hrp) {
+	stream_encoder_reset<bech32::bch::Blech32Code>(state, block, hrp);
+}
+
+void StreamEncoder::write(const void *in, size_t nbits_in) {
+	stream_encoder_write<bech32::bch::Blech32Code>(state, block, sink, in, nbits_in);
+}
+
+void StreamEncoder::finish(blech32_constant_t constant) {
+	stream_encoder_finish<bech32::bch::Blech32Code>(state, block, sink, constant);
+}
+
+void Decoder::reset(std::string_view in) {
+	this->reset(in, bech32::bch::Blech32Code::MAX_SIZE);
+}
+
+void Decoder::reset(std::string_view in, size_t n_max) {
+	hrp = decoder_reset<bech32::bch::Blech32Code>(state, in, n_max);
+}
+
+void Decoder::read(void *out, size_t nbits_out) {
+	decoder_read<bech32::bch::Blech32Code>(state, out, nbits_out);
+}
+
+std::vector<std::byte> Decoder::read(size_t nbits) {
+	if (nbits > this->bits_remaining())
+		throw bech32::Error(BECH32_TOO_SHORT);
+	std::vector<std::byte> out((nbits + CHAR_BIT - 1) / CHAR_BIT);
+	this->read(out.data(), nbits);
+	return out;
+}
+
+BitSpan Decoder::read_span(size_t nbits) {
+	return BitSpan(decoder_skip<bech32::bch::Blech32Code>(state, (nbits + 4) / 5));
+}
+
+TaggedFields Decoder::fields(size_t nbits_trailer) {
+	return decoder_fields<bech32::bch::Blech32Code>(state, nbits_trailer);
+}
+
+size_t Decoder::finish(blech32_constant_t constant) {
+	return decoder_finish<bech32::bch::Blech32Code>(state, constant);
+}
+
+size_t Decoder::finish_detect(blech32_constant_t &constant) {
+	return decoder_finish_detect<bech32::bch::Blech32, bech32::bch::Blech32m>(state, constant);
+}
+
+
+std::vector<std::byte> StreamDecoder::write(std::string_view in) {
+	return stream_decoder_write<bech32::bch::Blech32Code>(state, in);
+}
+
+std::vector<std::byte> StreamDecoder::finish(blech32_constant_t constant) {
+	return stream_decoder_finish<bech32::bch::Blech32Code>(state, constant);
+}
+
+
+std::string encode_segwit_address(const void *program, size_t n_program, std::string_view hrp, unsigned version) {
+	return encode_address<bech32::bch::BlindingAddress, struct ::blech32_encoder_state>(program, n_program, hrp, version);
+}
+
+std::tuple<std::vector<std::byte>, std::string_view, unsigned> decode_segwit_address(std::string_view address) {
+	return decode_address<bech32::bch::BlindingAddress, struct ::blech32_decoder_state>(address);
+}
+
+
+void AddressSet::reserve(size_t n) {
+	address_set_reserve(slots, n);
+}
+
+void AddressSet::clear() noexcept {
+	slots.clear(), entries.clear(), data.clear();
+}
+
+bool AddressSet::insert(std::string_view address) {
+	return address_set_insert<bech32::bch::BlindingAddress, struct ::blech32_decoder_state>(slots, entries, data, address);
+}
+
+size_t AddressSet::insert(std::span<const std::string_view> addresses) {
+	this->reserve(entries.size() + addresses.size());
+	size_t n = 0;
+	for (auto address : addresses)
+		n += this->insert(address);
+	return n;
+}
+
+bool AddressSet::contains(std::string_view address) const noexcept {
+	decltype(Slot::key) key;
+	return !slots.empty() && address_set_key<bech32::bch::BlindingAddress>(address, key) &&
+			address_set_contains<bech32::bch::BlindingAddress, struct ::blech32_decoder_state>(slots, entries, data, address, key);
+}
+
+size_t AddressSet::contains(std::span<const std::string_view> addresses, bool results[]) const noexcept {
+	return address_set_contains<bech32::bch::BlindingAddress, struct ::blech32_decoder_state>(slots, entries, data, addresses, results);
+}
+
+
+struct __attribute__ ((__visibility__ ("hidden"))) DecodeCache::Shard : decode_cache_shard<bech32::bch::BlindingAddress> { };
+
+DecodeCache::DecodeCache(size_t capacity) {
+	decode_cache_reserve(shards, capacity);
+}
+
+DecodeCache::DecodeCache(DecodeCache &&) noexcept = default;
+
+DecodeCache & DecodeCache::operator=(DecodeCache &&) noexcept = default;
+
+DecodeCache::~DecodeCache() = default;
+
+size_t DecodeCache::capacity() const noexcept {
+	return decode_cache_sum(shards, [](const Shard &shard) noexcept { return shard.capacity; });
+}
+
+size_t DecodeCache::size() const noexcept {
+	return decode_cache_sum(shards, [](const Shard &shard) noexcept { return shard.size(); });
+}
+
+uint_least64_t DecodeCache::hits() const noexcept {
+	return decode_cache_sum(shards, [](const Shard &shard) noexcept { return shard.hits.load(std::memory_order_relaxed); });
+}
+
+uint_least64_t DecodeCache::misses() const noexcept {
+	return decode_cache_sum(shards, [](const Shard &shard) noexcept { return shard.misses.load(std::memory_order_relaxed); });
+}
+
+void DecodeCache::clear() noexcept {
+	for (size_t i = 0; shards && i < SHARDS; ++i)
+		shards[i].clear();
+}
+
+std::tuple<std::vector<std::byte>, std::string_view, unsigned> DecodeCache::decode(std::string_view address) {
+	return decode_cache_decode<bech32::bch::BlindingAddress, struct ::blech32_decoder_state>(shards, address);
+}
+
+
+} // namespace blech32
+#endif // !defined(DISABLE_BLECH32)
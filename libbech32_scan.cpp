@@ -0,0 +1,171 @@
+#include "bech32_bch.h"
+
+#include <cstdint>
+
+#ifdef __SSE2__
+#	include <emmintrin.h>
+#endif
+
+using namespace bech32::bch;
+
+
+namespace {
+
+
+constexpr size_t BLOCK_SIZE = 16;
+
+constexpr size_t MAX_SIZE =
+#ifndef DISABLE_BLECH32
+		Blech32Code::MAX_SIZE;
+#else
+		Bech32Code::MAX_SIZE;
+#endif
+
+// Returns a mask in which bit i is set iff the i-th of the given bytes is an ASCII letter or digit.
+inline uint_fast32_t __attribute__ ((__pure__)) classify(const char *in) noexcept {
+#ifdef __SSE2__
+	__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+	// bytes with their high bits set compare as negative, so they fall outside both ranges
+	__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(x, _mm_set1_epi8('9' + 1)));
+	__m128i lower = _mm_or_si128(x, _mm_set1_epi8(0x20));
+	__m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+	return static_cast<uint_fast32_t>(_mm_movemask_epi8(_mm_or_si128(digit, alpha)));
+#else
+	uint_fast32_t mask = 0;
+	for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+		unsigned char c = static_cast<unsigned char>(in[i]), lower = c | 0x20;
+		mask |= static_cast<uint_fast32_t>((c >= '0' && c <= '9') || (lower >= 'a' && lower <= 'z')) << i;
+	}
+	return mask;
+#endif
+}
+
+// Determines which variant's checksum, if any, the given encoding satisfies. An encoding short enough to be either Bech32 or
+// Blech32 has the residues of both codes computed in a single pass over its characters; the two dependency chains are
+// independent, so the second costs little more than the first.
+inline ssize_t detect(const char *in, size_t n_in) noexcept {
+#ifndef DISABLE_BLECH32
+	if (n_in > Bech32Code::MAX_SIZE) {
+		Blech32Code::checksum_t chk;
+		if (ssize_t ret = Blech32Code::residue(&chk, in, n_in); ret < 0)
+			return ret;
+		if (chk == 1)
+			return BECH32_VARIANT_BLECH32;
+		if (chk == BLECH32M_CONST)
+			return BECH32_VARIANT_BLECH32M;
+		return BECH32_CHECKSUM_FAILURE;
+	}
+#endif
+	struct {
+		const char *in;
+		size_t n_in, nbits;
+		Bech32Code::checksum_t bits, chk;
+	} state;
+	ssize_t n_hrp = Bech32Code::decode_begin(&state, in, n_in);
+	if (n_hrp < 0)
+		return n_hrp;
+	Bech32Code::checksum_t chk = state.chk;
+	const char *p = state.in, *end = in + n_in;
+#ifndef DISABLE_BLECH32
+	if (static_cast<size_t>(end - p) >= Blech32Code::CHECKSUM_SIZE) {
+		Blech32Code::checksum_t blech_chk = Blech32Code::polymod_hrp(1, in, static_cast<size_t>(n_hrp));
+		for (; p != end; ++p) {
+			auto v = DECODE[*p - '0'];
+			chk = Bech32Code::polymod(chk) ^ v, blech_chk = Blech32Code::polymod(blech_chk) ^ v;
+		}
+		if (chk == 1)
+			return BECH32_VARIANT_BECH32;
+		if (chk == BECH32M_CONST)
+			return BECH32_VARIANT_BECH32M;
+		if (blech_chk == 1)
+			return BECH32_VARIANT_BLECH32;
+		if (blech_chk == BLECH32M_CONST)
+			return BECH32_VARIANT_BLECH32M;
+		return BECH32_CHECKSUM_FAILURE;
+	}
+#endif
+	for (; p != end; ++p)
+		chk = Bech32Code::polymod(chk) ^ DECODE[*p - '0'];
+	if (chk == 1)
+		return BECH32_VARIANT_BECH32;
+	if (chk == BECH32M_CONST)
+		return BECH32_VARIANT_BECH32M;
+	return BECH32_CHECKSUM_FAILURE;
+}
+
+class Scanner {
+	struct bech32_scan_match *matches;
+	size_t n_matches, n_found = 0;
+	const char *in;
+
+public:
+	Scanner(struct bech32_scan_match *matches, size_t n_matches, const char *in) noexcept : matches(matches), n_matches(n_matches), in(in) { }
+
+	size_t found() const noexcept { return n_found; }
+
+	// Examines the token spanning [begin, end) and returns true iff the array of matches has been filled.
+	bool token(size_t begin, size_t end) noexcept {
+		size_t n = end - begin;
+		if (n < Bech32Code::MIN_SIZE || n > MAX_SIZE || !::memchr(in + begin, '1', n))
+			return false;
+		if (ssize_t variant = detect(in + begin, n); variant > 0) {
+			matches[n_found++] = { begin, n, static_cast<enum bech32_variant>(variant) };
+			return n_found == n_matches;
+		}
+		return false;
+	}
+
+};
+
+
+} // namespace
+
+
+size_t bech32_scan(struct bech32_scan_match *__restrict matches, size_t n_matches, const char *__restrict in, size_t n_in, size_t *__restrict n_scanned) {
+	if (n_matches == 0) {
+		*n_scanned = 0;
+		return 0;
+	}
+	Scanner scanner(matches, n_matches, in);
+	size_t start = SIZE_MAX; // offset of the token in progress, if any
+	for (size_t block = 0; block < n_in; block += BLOCK_SIZE) {
+		uint_fast32_t mask;
+		if (n_in - block >= BLOCK_SIZE)
+			mask = classify(in + block);
+		else {
+			// classify a padded copy of the final partial block
+			char tail[BLOCK_SIZE] = { };
+			::memcpy(tail, in + block, n_in - block);
+			mask = classify(tail) & ((uint_fast32_t { 1 } << (n_in - block)) - 1);
+		}
+		// the common cases of a block entirely outside or entirely inside a token need no work
+		if (mask == (start == SIZE_MAX ? 0 : (uint_fast32_t { 1 } << BLOCK_SIZE) - 1))
+			continue;
+		for (unsigned pos = 0;;) {
+			uint_fast32_t rest = (start == SIZE_MAX ? mask : ~mask) >> pos << pos & ((uint_fast32_t { 1 } << BLOCK_SIZE) - 1);
+			if (!rest)
+				break;
+			pos = __builtin_ctzl(rest);
+			if (start == SIZE_MAX)
+				start = block + pos;
+			else {
+				size_t end = block + pos;
+				if (scanner.token(start, end)) {
+					*n_scanned = end;
+					return scanner.found();
+				}
+				start = SIZE_MAX;
+			}
+		}
+	}
+	// the final partial block's mask has no bits beyond the end of the input, so only a token that ends exactly at the end of
+	// a full block can still be in progress
+	if (start != SIZE_MAX)
+		scanner.token(start, n_in);
+	*n_scanned = n_in;
+	return scanner.found();
+}
+
+ssize_t bech32_detect(const char *in, size_t n_in) {
+	return detect(in, n_in);
+}
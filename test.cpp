@@ -1,10 +1,15 @@
 #include "bech32.h"
+#include "bech32_bch.h"
 
 #include <algorithm>
 #include <cassert>
 #include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <sstream>
 #include <ranges>
 #include <span>
+#include <thread>
 
 
 template <std::ranges::viewable_range R> requires std::same_as<std::ranges::range_value_t<R>, char>
@@ -46,6 +51,112 @@ static void test_invalid(std::string_view encoding, bool bech32m, enum ::bech32_
 	throw std::logic_error("should have thrown");
 }
 
+template <typename StreamDecoder>
+static std::vector<std::byte> stream_decode(std::string_view encoding, size_t chunk, size_t n_max, auto constant) {
+	StreamDecoder decoder(n_max);
+	std::vector<std::byte> bytes;
+	for (size_t i = 0; i < encoding.size(); i += chunk)
+		std::ranges::copy(decoder.write(encoding.substr(i, chunk)), std::back_inserter(bytes));
+	std::ranges::copy(decoder.finish(constant), std::back_inserter(bytes));
+	assert(std::ranges::equal(decoder.prefix(), encoding.substr(0, decoder.prefix().size())));
+	return bytes;
+}
+
+// Long inputs have their checksums computed in segments; reading a byte at a time keeps to the serial path.
+template <typename Code, typename Encoder, typename Decoder>
+static void test_segmented_checksum(std::string_view hrp, size_t n_bytes, auto constant) {
+	std::vector<std::byte> bytes(n_bytes);
+	for (size_t i = 0; i < n_bytes; ++i)
+		bytes[i] = static_cast<std::byte>(i * 73 + n_bytes);
+	Encoder encoder(hrp, n_bytes * CHAR_BIT);
+	encoder.write(bytes.data(), n_bytes * CHAR_BIT);
+	std::string encoding = encoder.finish(constant);
+	typename Code::checksum_t chk;
+	assert(Code::residue(&chk, encoding.data(), encoding.size()) == static_cast<ssize_t>(hrp.size()) && chk == constant);
+	enum { WHOLE, BYTEWISE, IN_PLACE };
+	auto decode = [&](std::string_view encoding, int mode) -> std::vector<std::byte> {
+		std::string buffer(encoding);
+		Decoder decoder(buffer);
+		std::vector<std::byte> decoded(n_bytes);
+		if (mode == BYTEWISE)
+			for (auto &byte : decoded)
+				decoder.read(&byte, CHAR_BIT);
+		else if (mode == IN_PLACE) {
+			// the bytes overwrite the characters they were decoded from, beginning immediately after the separator
+			auto out = reinterpret_cast<std::byte *>(buffer.data() + hrp.size() + 1/*separator*/);
+			decoder.read(out, n_bytes * CHAR_BIT);
+			std::copy_n(out, n_bytes, decoded.begin());
+			assert(std::string_view(buffer).substr(0, hrp.size() + 1) == encoding.substr(0, hrp.size() + 1));
+		}
+		else
+			decoder.read(decoded.data(), n_bytes * CHAR_BIT);
+		decoder.finish(constant);
+		return decoded;
+	};
+	assert(decode(encoding, WHOLE) == bytes && decode(encoding, BYTEWISE) == bytes && decode(encoding, IN_PLACE) == bytes);
+	for (size_t i = hrp.size() + 1/*separator*/; i < encoding.size(); i += 7) {
+		std::string mutated = encoding;
+		mutated[i] = mutated[i] == 'q' ? 'p' : 'q';
+		assert(Code::residue(&chk, mutated.data(), mutated.size()) >= 0 && chk != constant);
+		for (int mode : { WHOLE, BYTEWISE, IN_PLACE })
+			try {
+				decode(mutated, mode);
+				throw std::logic_error("should have thrown");
+			}
+			catch (const bech32::Error &e) {
+				assert(e.error == BECH32_CHECKSUM_FAILURE);
+			}
+	}
+}
+
+template <typename Encoder, typename StreamDecoder>
+static void test_stream_round_trip(std::string_view hrp, size_t n_bytes, size_t n_max, auto constant) {
+	std::vector<std::byte> bytes(n_bytes);
+	for (size_t i = 0; i < n_bytes; ++i)
+		bytes[i] = static_cast<std::byte>(i * 0x9E3779B1 >> 13);
+	Encoder encoder(hrp, n_bytes * CHAR_BIT);
+	encoder.write(bytes.data(), n_bytes * CHAR_BIT);
+	auto encoding = encoder.finish(constant);
+	for (size_t chunk : { size_t { 1 }, size_t { 7 }, size_t { 4096 } })
+		assert(std::ranges::equal(stream_decode<StreamDecoder>(encoding, chunk, n_max, constant), bytes));
+}
+
+template <typename Encoder, typename StreamEncoder>
+static void test_stream_encoder(std::string_view hrp, size_t n_bytes, auto constant) {
+	static_assert(!std::is_copy_constructible_v<StreamEncoder> && !std::is_move_constructible_v<StreamEncoder>);
+	std::vector<unsigned char> bytes(n_bytes);
+	for (size_t i = 0; i < n_bytes; ++i)
+		bytes[i] = static_cast<unsigned char>(i * 0x9E3779B1 >> 11);
+	const uint8_t version = 1;
+	Encoder encoder(hrp, 5 + n_bytes * CHAR_BIT);
+	encoder.write(&version, 5);
+	encoder.write(bytes.data(), n_bytes * CHAR_BIT);
+	auto expected = encoder.finish(constant);
+	std::string actual;
+	size_t n_blocks = 0;
+	StreamEncoder stream(hrp, [&](std::string_view block) {
+		assert(block.size() <= StreamEncoder::BLOCK_SIZE);
+		actual += block, ++n_blocks;
+	});
+	stream.write(&version, 5);
+	for (size_t i = 0; i < n_bytes; i += 1000)
+		stream.write(bytes.data() + i, std::min<size_t>(1000, n_bytes - i) * CHAR_BIT);
+	stream.finish(constant);
+	assert(actual == expected);
+	assert(n_blocks == (expected.size() + StreamEncoder::BLOCK_SIZE - 1) / StreamEncoder::BLOCK_SIZE);
+}
+
+static void test_stream_invalid(std::string_view encoding, bool bech32m, enum ::bech32_error reason) {
+	try {
+		stream_decode<bech32::StreamDecoder>(encoding, 3, BECH32_MAX_SIZE, bech32m ? BECH32M_CONST : 1);
+	}
+	catch (const bech32::Error &e) {
+		assert(e.error == reason);
+		return;
+	}
+	throw std::logic_error("should have thrown");
+}
+
 static void test_segwit_round_trip(std::string_view address, unsigned expect_version, std::span<const std::byte> expect_program) {
 	auto [program, hrp, version] = bech32::decode_segwit_address(address);
 	assert(version == expect_version);
@@ -76,6 +187,549 @@ static inline void test_segwit_round_trip(std::string_view address, unsigned ver
 	return test_segwit_round_trip(address, version, std::span<const std::byte, std::dynamic_extent>(bytes));
 }
 
+static void reverse_executor(void *ctx, void (*task)(void *, size_t), void *arg, size_t n_tasks) {
+	++*static_cast<size_t *>(ctx);
+	while (n_tasks)
+		(*task)(arg, --n_tasks);
+}
+
+template <auto encode, auto decode, auto encode_batch, auto decode_batch, size_t max_program, size_t max_address>
+static void test_address_batch(std::string_view hrp, size_t n_items, const struct bech32_executor *executor) {
+	std::vector<std::array<unsigned char, max_program + 1>> programs(n_items), decoded(n_items);
+	std::vector<std::array<char, max_address + 1>> addresses(n_items);
+	std::vector<struct bech32_address_encode_item> encode_items(n_items);
+	for (size_t i = 0; i < n_items; ++i) {
+		for (size_t j = 0; j < programs[i].size(); ++j)
+			programs[i][j] = static_cast<unsigned char>(i * 31 + j * 7);
+		encode_items[i] = { addresses[i].data(), addresses[i].size(), programs[i].data(), i % (max_program + 2), hrp.data(), hrp.size(), static_cast<unsigned>(i % (WITNESS_MAX_VERSION + 2)), 0 };
+	}
+	encode_batch(encode_items.data(), n_items, executor);
+	std::vector<struct bech32_address_decode_item> decode_items(n_items);
+	for (size_t i = 0; i < n_items; ++i) {
+		auto &item = encode_items[i];
+		char expect[max_address + 1];
+		assert(item.ret == encode(expect, sizeof expect, item.program, item.n_program, item.hrp, item.n_hrp, item.version));
+		size_t n_address = item.ret < 0 ? 0 : static_cast<size_t>(item.ret);
+		assert(std::string_view(item.address, n_address) == std::string_view(expect, n_address));
+		if (i % 5 == 0 && n_address)
+			item.address[n_address - 1] ^= 1; // corrupt some of the addresses
+		decode_items[i] = { decoded[i].data(), decoded[i].size(), item.address, n_address, 0, 0, 0 };
+	}
+	decode_batch(decode_items.data(), n_items, executor);
+	for (auto &item : decode_items) {
+		unsigned char expect[max_program + 1];
+		size_t n_hrp;
+		unsigned version;
+		assert(item.ret == decode(expect, sizeof expect, item.address, item.n_address, &n_hrp, &version));
+		if (item.ret >= 0)
+			assert(item.n_hrp == n_hrp && item.version == version && std::ranges::equal(std::span(item.program, static_cast<size_t>(item.ret)), std::span(expect, static_cast<size_t>(item.ret))));
+	}
+}
+
+template <auto decode, size_t max_program, size_t max_address>
+static void test_generate(const struct bech32_generate_params &params, size_t n_items, const struct bech32_executor *executor) {
+	std::vector<std::array<char, max_address + 1>> addresses(n_items);
+	std::vector<struct bech32_generate_item> items(n_items);
+	for (size_t i = 0; i < n_items; ++i)
+		items[i] = { addresses[i].data(), addresses[i].size(), BECH32_GENERATE_VALID, 0 };
+	::bech32_generate(items.data(), n_items, 0, &params, executor);
+	size_t n_invalid = 0, n_upper = 0;
+	uint32_t versions = 0;
+	for (auto &item : items) {
+		assert(item.ret > 0);
+		std::string_view address(item.address, static_cast<size_t>(item.ret));
+		unsigned char program[max_program];
+		size_t n_hrp;
+		unsigned version;
+		ssize_t ret = decode(program, sizeof program, address.data(), address.size(), &n_hrp, &version);
+		switch (item.fault) {
+			case BECH32_GENERATE_VALID:
+				assert(ret > 0);
+				assert(std::ranges::any_of(std::span(params.hrps, params.n_hrps), [&](const char *hrp) noexcept {
+					return std::ranges::equal(address.substr(0, n_hrp), lowercase_view(std::string_view(hrp)) | std::views::transform([&](char c) noexcept {
+						return address[0] >= 'A' && address[0] <= 'Z' && c >= 'a' ? static_cast<char>(c ^ 0x20) : c;
+					}));
+				}));
+				versions |= 1u << version, n_upper += address[0] >= 'A' && address[0] <= 'Z';
+				break;
+			case BECH32_GENERATE_MIXED_CASE:
+				assert(ret == BECH32_MIXED_CASE), ++n_invalid;
+				break;
+			case BECH32_GENERATE_ILLEGAL_CHAR:
+				assert(ret == BECH32_ILLEGAL_CHAR), ++n_invalid;
+				break;
+			default:
+				assert(item.fault == BECH32_GENERATE_BAD_CHECKSUM && ret < 0), ++n_invalid;
+		}
+	}
+	assert(n_invalid == n_items || versions == (params.versions ? params.versions : 0x3));
+	double expect_invalid = params.invalid * static_cast<double>(n_items);
+	assert(static_cast<double>(n_invalid) >= expect_invalid * 0.8 && static_cast<double>(n_invalid) <= expect_invalid * 1.2);
+	if (params.flags & BECH32_GENERATE_UPPERCASE)
+		assert(n_upper > (n_items - n_invalid) / 3 && n_upper < (n_items - n_invalid) * 2 / 3);
+	else
+		assert(n_upper == 0);
+
+	// any stretch of the corpus can be generated on its own
+	size_t begin = n_items / 3, end = n_items - n_items / 4;
+	std::vector<std::array<char, max_address + 1>> again(end - begin);
+	std::vector<struct bech32_generate_item> stretch(end - begin);
+	for (size_t i = 0; i < stretch.size(); ++i)
+		stretch[i] = { again[i].data(), again[i].size(), BECH32_GENERATE_VALID, 0 };
+	::bech32_generate(stretch.data(), stretch.size(), begin, &params, nullptr);
+	for (size_t i = 0; i < stretch.size(); ++i)
+		assert(stretch[i].ret == items[begin + i].ret && stretch[i].fault == items[begin + i].fault &&
+				std::string_view(stretch[i].address) == std::string_view(items[begin + i].address));
+}
+
+template <typename Address, typename DecoderState>
+static void test_fused_decode(std::string_view address) {
+	static constexpr std::string_view alphabet = "qpzry9x8gf2tvdw0s3jn54khce6mua7lQPZRY9X8GF2TVDW0S3JN54KHCE6MUA7L1bio\x20\x7F\x80";
+	auto check = [](std::string_view address) {
+		unsigned char fused[Address::PROGRAM_MAX_SIZE], stepwise[Address::PROGRAM_MAX_SIZE];
+		size_t fused_hrp = 0, stepwise_hrp = 0;
+		unsigned fused_version = 0, stepwise_version = 0;
+		ssize_t ret = Address::template decode<DecoderState>(fused, sizeof fused, address.data(), address.size(), &fused_hrp, &fused_version);
+		assert(ret == (Address::template decode_stepwise<DecoderState>(stepwise, sizeof stepwise, address.data(), address.size(), &stepwise_hrp, &stepwise_version)));
+		assert(fused_hrp == stepwise_hrp && fused_version == stepwise_version);
+		if (ret >= 0)
+			assert(std::ranges::equal(std::span(fused, static_cast<size_t>(ret)), std::span(stepwise, static_cast<size_t>(ret))));
+		std::string in_place(address);
+		size_t in_place_hrp = 0;
+		unsigned in_place_version = 0;
+		assert(ret == (Address::template decode_in_place<DecoderState>(in_place.data(), in_place.size(), &in_place_hrp, &in_place_version)));
+		if (ret >= 0) {
+			assert(in_place_hrp == fused_hrp && in_place_version == fused_version);
+			assert(std::string_view(in_place).substr(0, fused_hrp + 1) == address.substr(0, fused_hrp + 1));
+			assert(std::ranges::equal(std::span(reinterpret_cast<const unsigned char *>(in_place.data()) + fused_hrp + 1, static_cast<size_t>(ret)), std::span(fused, static_cast<size_t>(ret))));
+		}
+	};
+	check(address);
+	for (size_t i = 0; i < address.size(); ++i) {
+		std::string mutated(address);
+		check(mutated.erase(i, 1));
+		for (char c : alphabet) {
+			mutated = address, mutated[i] = c;
+			check(mutated);
+			check(mutated.insert(i, 1, c));
+		}
+	}
+}
+
+template <size_t ProgramSize, auto encode, auto decode>
+static void test_fixed_address(std::string_view address) {
+	static constexpr std::string_view alphabet = "qpzry9x8gf2tvdw0s3jn54khce6mua7lQPZRY9X8GF2TVDW0S3JN54KHCE6MUA7L1bio\x20\x7F\x80";
+	auto check = [](std::string_view address) noexcept {
+		unsigned char fixed[ProgramSize], generic[WITNESS_PROGRAM_MAX_SIZE];
+		size_t fixed_hrp = 0, generic_hrp = 0;
+		unsigned fixed_version = 0, generic_version = 0;
+		ssize_t ret = decode(fixed, address.data(), address.size(), &fixed_hrp, &fixed_version);
+		ssize_t expect = bech32_address_decode(generic, sizeof generic, address.data(), address.size(), &generic_hrp, &generic_version);
+		if (expect >= 0 && static_cast<size_t>(expect) != ProgramSize)
+			expect = SEGWIT_PROGRAM_ILLEGAL_SIZE;
+		assert(ret == expect);
+		if (ret < 0)
+			return;
+		assert(fixed_hrp == generic_hrp && fixed_version == generic_version && std::ranges::equal(fixed, std::span(generic, ProgramSize)));
+		char fixed_address[BECH32_MAX_SIZE + 1], generic_address[BECH32_MAX_SIZE + 1];
+		for (size_t n_address = 0; n_address <= address.size() + 1; n_address += address.size()) {
+			ret = encode(fixed_address, n_address, fixed, address.data(), fixed_hrp, fixed_version);
+			assert(ret == bech32_address_encode(generic_address, n_address, generic, ProgramSize, address.data(), generic_hrp, generic_version));
+			if (ret >= 0)
+				assert(std::string_view(fixed_address) == std::string_view(generic_address));
+		}
+	};
+	check(address);
+	for (size_t i = 0; i < address.size(); ++i) {
+		std::string mutated(address);
+		check(mutated.erase(i, 1));
+		for (char c : alphabet) {
+			mutated = address, mutated[i] = c;
+			check(mutated);
+			check(mutated.insert(i, 1, c));
+		}
+	}
+	unsigned char program[ProgramSize];
+	for (size_t i = 0; i < ProgramSize; ++i)
+		program[i] = static_cast<unsigned char>(i * 37 + 11);
+	std::string max_hrp(BECH32_HRP_MAX_SIZE, 'a'), long_hrp(BECH32_HRP_MAX_SIZE + 1, 'a');
+	for (std::string_view hrp : { std::string_view(""), std::string_view("bc"), std::string_view("TB"), std::string_view("b\x7F"), std::string_view(max_hrp), std::string_view(long_hrp) })
+		for (unsigned version = 0; version <= WITNESS_MAX_VERSION + 1; ++version) {
+			char fixed_address[BECH32_MAX_SIZE + 1], generic_address[BECH32_MAX_SIZE + 1];
+			ssize_t ret = encode(fixed_address, sizeof fixed_address, program, hrp.data(), hrp.size(), version);
+			assert(ret == bech32_address_encode(generic_address, sizeof generic_address, program, ProgramSize, hrp.data(), hrp.size(), version));
+			if (ret >= 0) {
+				assert(std::string_view(fixed_address) == std::string_view(generic_address));
+				auto [decoded, decoded_hrp, decoded_version] = bech32::FixedAddress<ProgramSize>::decode(fixed_address);
+				assert(std::ranges::equal(as_bytes(std::span(program)), decoded) && decoded_hrp.size() == hrp.size() && decoded_version == version);
+				assert(bech32::FixedAddress<ProgramSize>::encode(decoded, hrp, version) == fixed_address);
+			}
+		}
+}
+
+template <typename AddressSet>
+static void test_address_set(std::span<const std::string_view> members, std::span<const std::string_view> others) {
+	AddressSet set;
+	assert(!set.contains(members[0]));
+	assert(set.insert(members) == members.size());
+	assert(set.size() == members.size());
+	assert(set.insert(members) == 0);
+	for (auto address : members) {
+		assert(set.contains(address));
+		std::string upper;
+		std::ranges::transform(address, std::back_inserter(upper), [](char c) noexcept { return c >= 'a' && c <= 'z' ? static_cast<char>(c - 0x20) : c; });
+		assert(set.contains(upper));
+	}
+	for (auto address : others)
+		assert(!set.contains(address));
+	std::vector<std::string_view> probes(members.begin(), members.end());
+	probes.insert(probes.end(), others.begin(), others.end());
+	auto results = std::make_unique<bool[]>(probes.size());
+	assert(set.contains(probes, results.get()) == members.size());
+	for (size_t i = 0; i < probes.size(); ++i)
+		assert(results[i] == (i < members.size()));
+	try {
+		set.insert(others.back());
+		throw std::logic_error("should have thrown");
+	}
+	catch (const bech32::Error &) {
+	}
+	set.clear();
+	assert(set.empty() && !set.contains(members[0]));
+}
+
+template <typename DecodeCache>
+static void test_decode_cache(std::span<const std::string_view> addresses, std::string_view invalid, auto decode) {
+	// the addresses may be spread unevenly among the shards, but no shard can receive more than all of them
+	DecodeCache cache(addresses.size() * DecodeCache::SHARDS);
+	assert(cache.capacity() == addresses.size() * DecodeCache::SHARDS && cache.size() == 0);
+	for (unsigned pass = 0; pass < 2; ++pass)
+		for (auto address : addresses)
+			assert(cache.decode(address) == decode(address));
+	assert(cache.size() == addresses.size());
+	assert(cache.misses() == addresses.size() && cache.hits() == addresses.size());
+	try {
+		cache.decode(invalid);
+		throw std::logic_error("should have thrown");
+	}
+	catch (const bech32::Error &) {
+	}
+	assert(cache.size() == addresses.size() && cache.misses() == addresses.size() + 1);
+	// a moved-from cache remains usable, with no capacity
+	DecodeCache moved(std::move(cache));
+	assert(moved.size() == addresses.size() && cache.capacity() == 0 && cache.size() == 0 && cache.hits() == 0);
+	assert(cache.decode(addresses.front()) == decode(addresses.front()) && cache.misses() == 0);
+	cache.clear();
+	cache = std::move(moved);
+	cache.clear();
+	assert(cache.size() == 0 && cache.hits() == 0 && cache.misses() == 0);
+
+	// a cache much smaller than its working set keeps replacing its entries but still decodes correctly
+	DecodeCache small(DecodeCache::SHARDS * 2);
+	for (unsigned pass = 0; pass < 3; ++pass)
+		for (auto address : addresses) {
+			assert(small.decode(address) == decode(address));
+			assert(small.size() <= small.capacity());
+		}
+	assert(small.hits() + small.misses() == 3 * addresses.size());
+	// an entry that keeps being hit survives the sweeps
+	small.clear();
+	for (auto address : addresses)
+		small.decode(addresses.front()), small.decode(address);
+	uint_least64_t misses = small.misses();
+	small.decode(addresses.front());
+	assert(small.misses() == misses);
+
+	// concurrent lookups and insertions
+	DecodeCache shared(addresses.size() / 2);
+	std::vector<std::thread> threads;
+	constexpr unsigned THREADS = 4, PASSES = 3;
+	for (unsigned t = 0; t < THREADS; ++t)
+		threads.emplace_back([&, t] {
+			for (unsigned pass = 0; pass < PASSES; ++pass)
+				for (size_t i = 0; i < addresses.size(); ++i) {
+					auto address = addresses[(i * (t + 1) + pass) % addresses.size()];
+					assert(shared.decode(address) == decode(address));
+				}
+		});
+	for (auto &thread : threads)
+		thread.join();
+	assert(shared.hits() + shared.misses() == THREADS * PASSES * addresses.size());
+	assert(shared.size() <= shared.capacity());
+}
+
+static void test_address_set_file(std::span<const std::string> members, std::span<const std::string_view> others, unsigned flags) {
+	std::vector<const char *> addresses;
+	for (const auto &address : members)
+		addresses.push_back(address.c_str());
+	addresses.push_back(members.front().c_str()); // duplicates are stored once
+	unsigned char *file;
+	size_t bad = SIZE_MAX;
+	ssize_t n_file = ::bech32_address_set_build(&file, addresses.data(), addresses.size(), flags, &bad);
+	assert(n_file > 0 && bad == SIZE_MAX);
+	std::unique_ptr<unsigned char, decltype(&::free)> owner(file, &::free);
+	struct ::bech32_address_set set;
+	assert(::bech32_address_set_open(&set, file, static_cast<size_t>(n_file)) == 0);
+	assert(::bech32_address_set_open(&set, file, static_cast<size_t>(n_file) - 1) < 0);
+	assert(::bech32_address_set_open(&set, file, static_cast<size_t>(n_file)) == 0);
+	for (const auto &address : members)
+		assert(::bech32_address_set_contains(&set, address.data(), address.size()) == 1);
+	for (auto address : others)
+		assert(::bech32_address_set_contains(&set, address.data(), address.size()) <= 0);
+	addresses.push_back("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5");
+	assert(::bech32_address_set_build(&file, addresses.data(), addresses.size(), flags, &bad) < 0);
+	assert(bad == addresses.size() - 1);
+}
+
+template <typename Encoder>
+static std::string scan_encoding(std::string_view hrp, size_t n_bytes, unsigned seed, auto constant) {
+	Encoder encoder(hrp, n_bytes * CHAR_BIT);
+	for (size_t i = 0; i < n_bytes; ++i) {
+		auto byte = static_cast<unsigned char>(seed * 37 + i * 11);
+		encoder.write(&byte, CHAR_BIT);
+	}
+	auto encoding = encoder.finish(constant);
+	if (seed % 7 == 0)
+		std::ranges::transform(encoding, encoding.begin(), [](char c) noexcept { return c >= 'a' && c <= 'z' ? static_cast<char>(c - 0x20) : c; });
+	return encoding;
+}
+
+static void test_scan() {
+	static constexpr std::string_view delimiters[] = { " ", "\n", ": ", "\t\"", ",", "/", "\x80", std::string_view("\xFF\0", 2) };
+	std::string text;
+	std::vector<struct ::bech32_scan_match> expect;
+	for (unsigned i = 0; i < 400; ++i) {
+		std::string encoding;
+		enum ::bech32_variant variant;
+		switch (i % 4) {
+			case 0:
+				encoding = scan_encoding<bech32::Encoder>("bc", i % 50, i, 1), variant = BECH32_VARIANT_BECH32;
+				break;
+			case 1:
+				encoding = scan_encoding<bech32::Encoder>("tb", i % 50, i, BECH32M_CONST), variant = BECH32_VARIANT_BECH32M;
+				break;
+#ifndef DISABLE_BLECH32
+			case 2:
+				encoding = scan_encoding<blech32::Encoder>("el", i % 100, i, 1), variant = BECH32_VARIANT_BLECH32;
+				break;
+			default:
+				encoding = scan_encoding<blech32::Encoder>("lq", i % 100 + 200, i, BLECH32M_CONST), variant = BECH32_VARIANT_BLECH32M;
+				break;
+#else
+			default:
+				encoding = scan_encoding<bech32::Encoder>("a", i % 40, i, BECH32M_CONST), variant = BECH32_VARIANT_BECH32M;
+				break;
+#endif
+		}
+		text += delimiters[i % std::size(delimiters)];
+		if (i % 3 == 0) {
+			// decoys: a corrupted copy, a copy glued to another token, and some short words
+			std::string corrupted = encoding;
+			char &c = corrupted[corrupted.size() - 1 - i % 6];
+			c = static_cast<char>(c == 'q' || c == 'Q' ? c + 1 : c ^ 1);
+			text += corrupted + " x1y the " + encoding + "z";
+			text += delimiters[(i + 1) % std::size(delimiters)];
+		}
+		expect.push_back({ text.size(), encoding.size(), variant });
+		text += encoding;
+	}
+	auto check = [&](std::string_view text, std::span<const struct ::bech32_scan_match> expect) {
+		std::vector<struct ::bech32_scan_match> matches(expect.size() + 1);
+		size_t n_scanned;
+		size_t n_matches = ::bech32_scan(matches.data(), matches.size(), text.data(), text.size(), &n_scanned);
+		assert(n_matches == expect.size() && n_scanned == text.size());
+		for (size_t i = 0; i < n_matches; ++i)
+			assert(matches[i].offset == expect[i].offset && matches[i].length == expect[i].length && matches[i].variant == expect[i].variant);
+		// resume a scan that is limited to one match at a time
+		for (size_t offset = 0, i = 0; offset < text.size(); ++i) {
+			n_matches = ::bech32_scan(matches.data(), 1, text.data() + offset, text.size() - offset, &n_scanned);
+			if (i < expect.size())
+				assert(n_matches == 1 && matches[0].offset + offset == expect[i].offset && offset + n_scanned == expect[i].offset + expect[i].length);
+			else
+				assert(n_matches == 0 && n_scanned == text.size() - offset);
+			offset += n_scanned;
+		}
+	};
+	check(text, expect);
+	// shift the final match to end at every position within a block
+	for (size_t n_pad = 1; n_pad <= 16; ++n_pad) {
+		for (auto &match : expect)
+			++match.offset;
+		check(std::string(n_pad, ' ') + text, expect);
+	}
+	size_t n_scanned = SIZE_MAX;
+	assert(::bech32_scan(nullptr, 0, text.data(), text.size(), &n_scanned) == 0 && n_scanned == 0);
+	assert(::bech32_scan(expect.data(), expect.size(), "", 0, &n_scanned) == 0 && n_scanned == 0);
+}
+
+template <typename Decoder>
+static void test_detect(const std::string &encoding, enum ::bech32_variant variant, auto constant) {
+	assert(::bech32_detect(encoding.data(), encoding.size()) == variant);
+	Decoder decoder(encoding);
+	decoder.read();
+	decltype(constant) detected = 0;
+	decoder.finish_detect(detected);
+	assert(detected == constant);
+	// replacing the last character with another legal one breaks the checksum of every variant
+	std::string corrupted = encoding;
+	char q = encoding.front() >= 'a' ? 'q' : 'Q';
+	corrupted.back() = corrupted.back() == q ? static_cast<char>(q - 1) : q;
+	assert(::bech32_detect(corrupted.data(), corrupted.size()) == BECH32_CHECKSUM_FAILURE);
+	try {
+		Decoder decoder(corrupted);
+		decoder.read();
+		decoder.finish_detect(detected);
+	}
+	catch (const bech32::Error &e) {
+		assert(e.error == BECH32_CHECKSUM_FAILURE);
+		return;
+	}
+	throw std::logic_error("should have thrown");
+}
+
+// The example invoice with a payment secret and features from BOLT11, which is longer than BECH32_MAX_SIZE.
+static void test_tagged_fields() {
+	constexpr std::string_view invoice = "lnbc1pvjluezsp5zyg3zyg3zyg3zyg3zyg3zyg3zyg3zyg3zyg3zyg3zyg3zyg3zygspp5qqqsyqcyq5rqwzqfqqqsyqcyq5rqwzqfqqqsyqcyq5rqwzqfqypqdpl2pkx2ctnv5sxxmmwwd5kgetjypeh2ursdae8g6twvus8g6rfwvs8qun0dfjkxaq9qrsgq357wnc5r2ueh7ck6q93dj32dlqnls087fxdwk8qakdyafkq3yap9us6v52vjjsrvywa6rt52cm9r9zqt8r2t7mlcwspyetp5h2tztugp9lfyql";
+	try {
+		bech32::Decoder decoder(invoice);
+		throw std::logic_error("should have thrown");
+	}
+	catch (const bech32::Error &e) {
+		assert(e.error == BECH32_TOO_LONG);
+	}
+	auto expect_error = [](auto &&func, enum ::bech32_error reason) {
+		try {
+			func();
+			throw std::logic_error("should have thrown");
+		}
+		catch (const bech32::Error &e) {
+			assert(e.error == reason);
+		}
+	};
+
+	bech32::Decoder decoder(invoice, SIZE_MAX);
+	assert(decoder.prefix() == "lnbc");
+	bech32::BitSpan timestamp = decoder.read_span(35);
+	assert(timestamp.symbols() == "pvjluez" && timestamp.size() == 35 && timestamp.value() == 1496314658);
+	expect_error([&] { decoder.fields(520 + 5); }, BECH32_TOO_SHORT); // cuts the last field short
+	bech32::TaggedFields fields = decoder.fields(520);
+	assert(decoder.bits_remaining() == 520);
+	static_assert(std::ranges::forward_range<bech32::TaggedFields>);
+	static_assert(std::is_same_v<std::iterator_traits<std::ranges::iterator_t<bech32::TaggedFields>>::iterator_category, std::input_iterator_tag>);
+	assert(std::ranges::distance(fields) == 4);
+	const unsigned expect_tags[] = { 16, 1, 13, 5 };
+	const size_t expect_lengths[] = { 52, 52, 63, 3 };
+	assert(std::ranges::equal(fields | std::views::transform([](const bech32::TaggedField &field) noexcept { return field.tag; }), expect_tags));
+	assert(std::ranges::equal(fields | std::views::transform([](const bech32::TaggedField &field) noexcept { return field.length; }), expect_lengths));
+	auto it = fields.begin();
+	auto secret = (*it++).data.bytes();
+	assert(secret.size() == 32 && std::ranges::all_of(secret, [](std::byte b) noexcept { return b == std::byte { 0x11 }; }));
+	auto hash = (*it++).data.bytes();
+	for (size_t i = 0; i < 32; ++i)
+		assert(hash[i] == static_cast<std::byte>(i < 30 ? i % 10 : i - 29));
+	auto description = (*it++).data.bytes();
+	assert(std::string_view(reinterpret_cast<const char *>(description.data()), description.size()) == "Please consider supporting this project");
+	bech32::BitSpan features = (*it++).data;
+	assert(it == fields.end() && features.value() == 0x4100);
+	unsigned char partial[2];
+	features.read(partial, 13);
+	assert(partial[0] == 0x82 && partial[1] == 0x00);
+	expect_error([&] { features.read(partial, 16); }, BECH32_TOO_SHORT);
+	expect_error([&] { fields.front().data.value(); }, BECH32_TOO_LONG);
+	auto signature = decoder.read_span(520).bytes();
+	assert(signature.size() == 65 && signature.front() == std::byte { 0x8d } && signature.back() == std::byte { 0x01 });
+	assert(decoder.finish(1) == 0);
+
+	// the fields consumed in place are covered by the checksum
+	std::string corrupted(invoice);
+	corrupted[corrupted.find("dpl") + 5] ^= 'q' ^ 'p';
+	decoder.reset(corrupted, SIZE_MAX);
+	decoder.read_span(35);
+	decoder.fields(520);
+	decoder.read_span(520);
+	expect_error([&] { decoder.finish(1); }, BECH32_CHECKSUM_FAILURE);
+
+	decoder.reset(invoice, SIZE_MAX);
+	unsigned char bits;
+	decoder.read(&bits, 3);
+	expect_error([&] { decoder.read_span(5); }, BECH32_PADDING_ERROR);
+	expect_error([&] { decoder.fields(); }, BECH32_PADDING_ERROR);
+	expect_error([&] { bech32::TaggedFields("qq"); }, BECH32_TOO_SHORT);
+	assert(bech32::TaggedFields("qqq").front().length == 0);
+}
+
+template <typename View>
+static void test_view_invalid(View &&view, size_t n_expect, enum ::bech32_error reason) {
+	size_t n = 0;
+	try {
+		for (auto it = view.begin(); it != view.end(); ++it)
+			++n;
+	}
+	catch (const bech32::Error &e) {
+		assert(e.error == reason && n == n_expect);
+		return;
+	}
+	throw std::logic_error("should have thrown");
+}
+
+static void test_views() {
+	static_assert(std::ranges::view<bech32::views::decode_view> && std::ranges::input_range<bech32::views::decode_view>);
+	static_assert(std::ranges::view<bech32::views::encode_view<std::span<const std::byte>>>);
+	for (size_t n_bytes : { 0, 1, 2, 20, 32, 49, 50 }) {
+		std::vector<std::byte> bytes(n_bytes);
+		for (size_t i = 0; i < n_bytes; ++i)
+			bytes[i] = static_cast<std::byte>(i * 37 + 11);
+		bech32::Encoder encoder("bc", n_bytes * CHAR_BIT);
+		encoder.write(bytes.data(), n_bytes * CHAR_BIT);
+		auto expect = encoder.finish(1);
+		assert(std::ranges::equal(bech32::views::encode("BC", bytes, 1), expect));
+		assert(std::ranges::equal(bytes | bech32::views::encode("bc", 1), expect));
+		auto decoded = bech32::views::decode(expect, 1);
+		assert(decoded.prefix() == "bc");
+		assert(std::ranges::equal(decoded, bytes));
+		// re-encode as Bech32m through a pipeline that holds no intermediate buffer
+		bech32::Encoder reencoder("tb", n_bytes * CHAR_BIT);
+		reencoder.write(bytes.data(), n_bytes * CHAR_BIT);
+		assert(std::ranges::equal(bech32::views::decode(expect, 1) | bech32::views::encode("tb"), reencoder.finish()));
+		std::istringstream iss(std::string(reinterpret_cast<const char *>(bytes.data()), n_bytes));
+		iss >> std::noskipws;
+		assert(std::ranges::equal(bech32::views::encode("bc", std::views::istream<char>(iss), 1), expect));
+		// the checksum is verified only at the end, after every byte has been yielded
+		std::string corrupted = expect;
+		corrupted.back() = corrupted.back() == 'q' ? 'p' : 'q';
+		test_view_invalid(bech32::views::decode(corrupted, 1), n_bytes, BECH32_CHECKSUM_FAILURE);
+		test_view_invalid(bech32::views::decode(expect), n_bytes, BECH32_CHECKSUM_FAILURE);
+	}
+	assert(std::ranges::equal(bech32::views::decode("bc1sw50qgdz25j") | std::views::take(1), std::array { std::byte { 0x83 } }));
+	// a SegWit address has a 5-bit version field ahead of its program, so its bytes do not align
+	test_view_invalid(bech32::views::decode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4", 1), 20, BECH32_PADDING_ERROR);
+	try {
+		bech32::views::encode("b c", std::array<std::byte, 0> { });
+		throw std::logic_error("should have thrown");
+	}
+	catch (const bech32::Error &e) {
+		assert(e.error == BECH32_HRP_ILLEGAL_CHAR);
+	}
+#ifndef DISABLE_BLECH32
+	// an encoding longer than the view's buffer
+	std::vector<unsigned char> bytes(600);
+	for (size_t i = 0; i < bytes.size(); ++i)
+		bytes[i] = static_cast<unsigned char>(i * 13);
+	blech32::Encoder encoder("el", bytes.size() * CHAR_BIT);
+	encoder.write(bytes.data(), bytes.size() * CHAR_BIT);
+	auto expect = encoder.finish();
+	assert(std::ranges::equal(bytes | blech32::views::encode("el"), expect));
+	assert(std::ranges::equal(blech32::views::decode(expect) | std::views::transform([](std::byte b) noexcept {
+		return static_cast<unsigned char>(b);
+	}), bytes));
+#endif
+}
+
+void test_header_only(); // in test_header_only.cpp
+
+static_assert(bech32::bch::Bech32Code::encoded_size(2, 5 + 20 * CHAR_BIT, 0) == 42);
+static_assert(bech32::bch::Bech32m::CONSTANT == BECH32M_CONST);
+
 int main() {
 	// HASH160(0279BE667EF9DCBBAC55A06295CE870B07029BFCDB2DCE28D959F2815B16F81798)
 	static constexpr uint8_t pkh[20] = {
@@ -149,6 +803,44 @@ int main() {
 	test_invalid("hi1fpjkcmr0ypmx7unvvssszef0zk", false, BECH32_CHECKSUM_FAILURE);
 	test_invalid("hi1fpjkcmr0ypmx7unvvsssh9er85", true, BECH32_CHECKSUM_FAILURE);
 
+	test_stream_round_trip<bech32::Encoder, bech32::StreamDecoder>("bc", 0, BECH32_MAX_SIZE, 1);
+	test_stream_round_trip<bech32::Encoder, bech32::StreamDecoder>("bc", 21, BECH32_MAX_SIZE, BECH32M_CONST);
+	test_stream_round_trip<bech32::Encoder, bech32::StreamDecoder>("lnbc1", 100000, SIZE_MAX, BECH32M_CONST);
+	test_tagged_fields();
+	for (size_t n_bytes : { 39, 40, 50 })
+		test_segmented_checksum<bech32::bch::Bech32Code, bech32::Encoder, bech32::Decoder>("bc", n_bytes, bech32_constant_t { 1 });
+#ifndef DISABLE_BLECH32
+	test_stream_round_trip<blech32::Encoder, blech32::StreamDecoder>("el", 600, BLECH32_MAX_SIZE, BLECH32M_CONST);
+	for (size_t n_bytes : { 30, 39, 40, 41, 100, 400, 600 })
+		test_segmented_checksum<bech32::bch::Blech32Code, blech32::Encoder, blech32::Decoder>("el", n_bytes, BLECH32M_CONST);
+	test_stream_round_trip<blech32::Encoder, blech32::StreamDecoder>("el", 5000, SIZE_MAX, 1);
+#endif
+
+	test_stream_encoder<bech32::Encoder, bech32::StreamEncoder>("bc", 0, 1);
+	test_stream_encoder<bech32::Encoder, bech32::StreamEncoder>("bc", 32, BECH32M_CONST);
+	test_stream_encoder<bech32::Encoder, bech32::StreamEncoder>("lnbc1", 100000, BECH32M_CONST);
+	{
+		std::ostringstream os;
+		bech32::StreamEncoder stream("bc", bech32::ostream_sink(os));
+		stream.finish(1);
+		assert(os.str() == "bc1gmk9yu");
+	}
+#ifndef DISABLE_BLECH32
+	test_stream_encoder<blech32::Encoder, blech32::StreamEncoder>("el", 65, BLECH32M_CONST);
+	test_stream_encoder<blech32::Encoder, blech32::StreamEncoder>("el", 20000, 1);
+#endif
+
+	test_stream_invalid("an84characterslonghumanreadablepartthatcontainsthenumber1andtheexcludedcharactersbio1569pvx", false, BECH32_TOO_LONG);
+	test_stream_invalid("pzry9x0s0muk", false, BECH32_NO_SEPARATOR);
+	test_stream_invalid("1pzry9x0s0muk", false, BECH32_HRP_TOO_SHORT);
+	test_stream_invalid("\x7F""1axkwrx", false, BECH32_HRP_ILLEGAL_CHAR);
+	test_stream_invalid("x1b4n0q5v", false, BECH32_ILLEGAL_CHAR);
+	test_stream_invalid("li1dgmt3", false, BECH32_TOO_SHORT);
+	test_stream_invalid("A1G7SGD8", false, BECH32_CHECKSUM_FAILURE);
+	test_stream_invalid("a1lqfn39", true, BECH32_CHECKSUM_FAILURE);
+	test_stream_invalid("tb1qrp33g0q5c5txsp9arysrx4k6zdkfs4nce4xj0gdcccefvpysxf3q0sL5k7", false, BECH32_MIXED_CASE);
+	test_stream_invalid("11llllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllllludsr8", true, BECH32_PADDING_ERROR);
+
 	test_segwit_round_trip("BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4", 0, pkh);
 	test_segwit_round_trip("tb1qrp33g0q5c5txsp9arysrx4k6zdkfs4nce4xj0gdcccefvpysxf3q0sl5k7", 0, sh);
 	test_segwit_round_trip("bc1pw508d6qejxtdg4y5r3zarvary0c5xw7kw508d6qejxtdg4y5r3zarvary0c5xw7kt5nd6y", 1, {
@@ -201,5 +893,160 @@ int main() {
 	test_segwit_invalid("BC1SW50QA3JX3S", BECH32_CHECKSUM_FAILURE);
 	test_segwit_invalid("bc1zw508d6qejxtdg4y5r3zarvaryvg6kdaj", BECH32_CHECKSUM_FAILURE);
 
+	{
+		size_t n_runs = 0;
+		struct bech32_executor executor = { &reverse_executor, &n_runs };
+		test_address_batch<&bech32_address_encode, &bech32_address_decode, &bech32_address_encode_batch, &bech32_address_decode_batch, WITNESS_PROGRAM_MAX_SIZE, BECH32_MAX_SIZE>("bc", 10, nullptr);
+		test_address_batch<&bech32_address_encode, &bech32_address_decode, &bech32_address_encode_batch, &bech32_address_decode_batch, WITNESS_PROGRAM_MAX_SIZE, BECH32_MAX_SIZE>("bc", BECH32_BATCH_THRESHOLD * 20 + 7, nullptr);
+		test_address_batch<&bech32_address_encode, &bech32_address_decode, &bech32_address_encode_batch, &bech32_address_decode_batch, WITNESS_PROGRAM_MAX_SIZE, BECH32_MAX_SIZE>("tb", BECH32_BATCH_THRESHOLD - 1, &executor);
+		assert(n_runs == 0);
+		test_address_batch<&bech32_address_encode, &bech32_address_decode, &bech32_address_encode_batch, &bech32_address_decode_batch, WITNESS_PROGRAM_MAX_SIZE, BECH32_MAX_SIZE>("tb", BECH32_BATCH_THRESHOLD * 3, &executor);
+		assert(n_runs == 2);
+#ifndef DISABLE_BLECH32
+		test_address_batch<&blech32_address_encode, &blech32_address_decode, &blech32_address_encode_batch, &blech32_address_decode_batch, BLINDING_PROGRAM_MAX_SIZE, BLECH32_MAX_SIZE>("el", BECH32_BATCH_THRESHOLD * 5, nullptr);
+		test_address_batch<&blech32_address_encode, &blech32_address_decode, &blech32_address_encode_batch, &blech32_address_decode_batch, BLINDING_PROGRAM_MAX_SIZE, BLECH32_MAX_SIZE>("tlq", BECH32_BATCH_THRESHOLD * 2, &executor);
+		assert(n_runs == 4);
+#endif
+	}
+
+	{
+		size_t n_runs = 0;
+		struct bech32_executor executor = { &reverse_executor, &n_runs };
+		static constexpr const char *hrps[] = { "bc", "tb", "BCRT" };
+		struct bech32_generate_params params = { 42, hrps, std::size(hrps), 0, 0.25, 0, BECH32_GENERATE_UPPERCASE };
+		test_generate<&bech32_address_decode, WITNESS_PROGRAM_MAX_SIZE, BECH32_MAX_SIZE>(params, BECH32_BATCH_THRESHOLD * 8, nullptr);
+		params.versions = 1 << 0 | 1 << 2 | 1 << 16, params.invalid = 0.05, params.flags = 0;
+		test_generate<&bech32_address_decode, WITNESS_PROGRAM_MAX_SIZE, BECH32_MAX_SIZE>(params, BECH32_BATCH_THRESHOLD * 4, &executor);
+		assert(n_runs == 1);
+		params.invalid = 1, params.faults = BECH32_GENERATE_ILLEGAL_CHAR | BECH32_GENERATE_MIXED_CASE;
+		test_generate<&bech32_address_decode, WITNESS_PROGRAM_MAX_SIZE, BECH32_MAX_SIZE>(params, 100, nullptr);
+#ifndef DISABLE_BLECH32
+		static constexpr const char *blech_hrps[] = { "el", "lq" };
+		params = { 7, blech_hrps, std::size(blech_hrps), 0x7, 0.5, BECH32_GENERATE_BAD_CHECKSUM, BECH32_GENERATE_BLECH32 | BECH32_GENERATE_UPPERCASE };
+		test_generate<&blech32_address_decode, BLINDING_PROGRAM_MAX_SIZE, BLECH32_MAX_SIZE>(params, BECH32_BATCH_THRESHOLD * 2, nullptr);
+#endif
+
+		char address[BECH32_MAX_SIZE + 1];
+		struct bech32_generate_item item = { address, sizeof address, BECH32_GENERATE_VALID, 0 };
+		params = { 0, hrps, 1, 1 << 17, 0, 0, 0 };
+		::bech32_generate(&item, 1, 0, &params, nullptr);
+		assert(item.ret == SEGWIT_VERSION_ILLEGAL);
+		item.n_address = 10, params.versions = 0;
+		::bech32_generate(&item, 1, 0, &params, nullptr);
+		assert(item.ret == BECH32_BUFFER_INADEQUATE);
+	}
+
+	for (auto address : {
+			"bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4",
+			"BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4",
+			"tb1qrp33g0q5c5txsp9arysrx4k6zdkfs4nce4xj0gdcccefvpysxf3q0sl5k7",
+			"bc1pw508d6qejxtdg4y5r3zarvary0c5xw7kw508d6qejxtdg4y5r3zarvary0c5xw7kt5nd6y",
+			"BC1SW50QGDZ25J",
+			"bc1zw508d6qejxtdg4y5r3zarvaryvaxxpcs",
+			"bc1zw508d6qejxtdg4y5r3zarvaryvqyzf3du",
+			"tb1p0xlxvlhemja6c4dqv22uapctqupfhlxm9h8z3k2e72q4k9hcz7vpggkg4j",
+			"bc10w508d6qejxtdg4y5r3zarvary0c5xw7kw508d6qejxtdg4y5r3zarvary0c5xw7kw5rljs90",
+			"a1b1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4" })
+		test_fused_decode<bech32::bch::SegwitAddress, struct ::bech32_decoder_state>(address);
+	{
+		char address[] = "BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4";
+		size_t n_hrp;
+		unsigned version;
+		static constexpr unsigned char program[] = {
+			0x75, 0x1e, 0x76, 0xe8, 0x19, 0x91, 0x96, 0xd4, 0x54, 0x94, 0x1c, 0x45, 0xd1, 0xb3, 0xa3, 0x23, 0xf1, 0x43, 0x3b, 0xd6
+		};
+		assert(::bech32_address_decode_in_place(address, sizeof address - 1, &n_hrp, &version) == sizeof program);
+		assert(n_hrp == 2 && version == 0 && std::string_view(address, 3) == "BC1");
+		assert(std::ranges::equal(std::span(reinterpret_cast<const unsigned char *>(address) + 3, sizeof program), program));
+	}
+	for (auto address : {
+			"bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4",
+			"BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4",
+			"bc1zw508d6qejxtdg4y5r3zarvary0c5xw7kg3g4ty",
+			"tb1qrp33g0q5c5txsp9arysrx4k6zdkfs4nce4xj0gdcccefvpysxf3q0sl5k7",
+			"bc1p0xlxvlhemja6c4dqv22uapctqupfhlxm9h8z3k2e72q4k9hcz7vqzk5jj0" }) {
+		test_fixed_address<WITNESS_PROGRAM_PKH_SIZE, &bech32_address_encode_20, &bech32_address_decode_20>(address);
+		test_fixed_address<WITNESS_PROGRAM_SH_SIZE, &bech32_address_encode_32, &bech32_address_decode_32>(address);
+	}
+	try {
+		bech32::FixedAddress<WITNESS_PROGRAM_SH_SIZE>::decode("bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4");
+		throw std::logic_error("should have thrown");
+	}
+	catch (const bech32::Error &e) {
+		assert(e.error == SEGWIT_PROGRAM_ILLEGAL_SIZE);
+	}
+#ifndef DISABLE_BLECH32
+	for (auto address : {
+			"el1qqw3e3mk4ng3ks43mh54udznuekaadh9lgwef3mwgzrfzakmdwcvqpe4ppdaa3t44v3zv2u6w56pv6tc666fvgzaclqjnkz0sd",
+			"el1pq0umk3pez693jrrlxz9ndlkuwne93gdu9g83mhhzuyf46e3mdzfpva0w48gqgzgrklncnm0k5zeyw8my2ypfsqzfcvvs8dc05u" })
+		test_fused_decode<bech32::bch::BlindingAddress, struct ::blech32_decoder_state>(address);
+#endif
+
+	{
+		std::vector<std::string> generated;
+		for (unsigned i = 0; i < 1000; ++i) {
+			unsigned char program[32] = { static_cast<unsigned char>(i), static_cast<unsigned char>(i >> 8) };
+			generated.push_back(bech32::encode_segwit_address(program, i % 2 ? 20 : 32, i % 3 ? "bc" : "tb", i % 5 ? 0 : 1));
+		}
+		std::vector<std::string_view> members(generated.begin(), generated.end());
+		std::string same_checksum = generated[0];
+		same_checksum[3] = same_checksum[3] == 'q' ? 'p' : 'q'; // a different address with the same checksum characters
+		static constexpr std::string_view others[] = {
+			"bc1pw508d6qejxtdg4y5r3zarvary0c5xw7kw508d6qejxtdg4y5r3zarvary0c5xw7kt5nd6y",
+			"bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4",
+			"bc1", "", "BC1QW508D6QEJXTDG4y5r3zarvary0c5xw7kv8f3t4",
+			"bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5",
+		};
+		std::vector<std::string_view> nonmembers(std::begin(others), std::end(others));
+		nonmembers.insert(nonmembers.begin(), same_checksum);
+		test_address_set<bech32::AddressSet>(members, nonmembers);
+		test_decode_cache<bech32::DecodeCache>(members, others[5], bech32::decode_segwit_address);
+		test_address_set_file(generated, nonmembers, 0);
+		test_address_set_file(generated, nonmembers, BECH32_ADDRESS_SET_EYTZINGER);
+		test_address_set_file(std::span(generated).first(1), nonmembers, BECH32_ADDRESS_SET_EYTZINGER);
+	}
+#ifndef DISABLE_BLECH32
+	{
+		std::vector<std::string> generated;
+		for (unsigned i = 0; i < 100; ++i) {
+			unsigned char program[BLINDING_PROGRAM_SH_SIZE] = { static_cast<unsigned char>(i), 2 };
+			generated.push_back(blech32::encode_segwit_address(program, i % 2 ? BLINDING_PROGRAM_PKH_SIZE : BLINDING_PROGRAM_SH_SIZE, "el", 0));
+		}
+		std::vector<std::string_view> members(generated.begin(), generated.end());
+		static constexpr std::string_view others[] = { "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4", "el1qqqqqqqqqqqqqqqqqqqqq" };
+		test_address_set<blech32::AddressSet>(members, others);
+		test_decode_cache<blech32::DecodeCache>(members, others[1], blech32::decode_segwit_address);
+		test_address_set_file(generated, others, BECH32_ADDRESS_SET_BLECH32 | BECH32_ADDRESS_SET_EYTZINGER);
+	}
+#endif
+
+	test_scan();
+
+	test_views();
+
+	for (unsigned i = 0; i < 60; ++i) {
+		test_detect<bech32::Decoder>(scan_encoding<bech32::Encoder>("bc", i % 50, i, 1), BECH32_VARIANT_BECH32, bech32_constant_t { 1 });
+		test_detect<bech32::Decoder>(scan_encoding<bech32::Encoder>("tb", i % 50, i, BECH32M_CONST), BECH32_VARIANT_BECH32M, BECH32M_CONST);
+#ifndef DISABLE_BLECH32
+		test_detect<blech32::Decoder>(scan_encoding<blech32::Encoder>("el", i * 5, i, 1), BECH32_VARIANT_BLECH32, blech32_constant_t { 1 });
+		test_detect<blech32::Decoder>(scan_encoding<blech32::Encoder>("lq", i * 5, i, BLECH32M_CONST), BECH32_VARIANT_BLECH32M, BLECH32M_CONST);
+#endif
+	}
+	assert(::bech32_detect("", 0) == BECH32_TOO_SHORT);
+	assert(::bech32_detect("A1lqfn3a", 8) == BECH32_MIXED_CASE);
+	assert(::bech32_detect("a1lqfn3b", 8) == BECH32_ILLEGAL_CHAR);
+	assert(::bech32_detect("a1lqfn3q", 8) == BECH32_CHECKSUM_FAILURE);
+	{
+		std::string long_encoding(BECH32_MAX_SIZE + 1, 'q');
+		long_encoding[1] = '1';
+#ifndef DISABLE_BLECH32
+		assert(::bech32_detect(long_encoding.data(), long_encoding.size()) == BECH32_CHECKSUM_FAILURE);
+		long_encoding.resize(BLECH32_MAX_SIZE + 1, 'q');
+#endif
+		assert(::bech32_detect(long_encoding.data(), long_encoding.size()) == BECH32_TOO_LONG);
+	}
+
+	test_header_only();
+
 	return 0;
 }
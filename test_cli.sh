@@ -0,0 +1,259 @@
+#!/bin/sh
+# Tests the command-line tool as built in the current directory, or as given by $BECH32. Whatever the tool does directly it
+# must do identically through a server started with --serve, and the server must refuse malformed frames without dying.
+
+BECH32=${BECH32:-./bech32}
+tmp=$(mktemp -d "${TMPDIR:-/tmp}/bech32-test.XXXXXX") || exit 99
+sock=$tmp/socket
+pids=
+trap 'kill $pids 2>/dev/null; rm -rf "$tmp"' EXIT
+failed=0
+
+fail() {
+	echo "FAIL: $*" >&2
+	failed=1
+}
+
+# Starts a server on the socket and waits for it to listen.
+start_server() {
+	"$BECH32" --serve="$sock" &
+	pid=$! pids="$pids $!"
+	for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20; do
+		test -S "$sock" && "$BECH32" --connect="$sock" bc </dev/null >/dev/null 2>&1 && return 0
+		sleep 0.1
+	done
+	echo "server did not start" >&2
+	exit 99
+}
+
+# Runs the tool with the given arguments on the file $input, directly and through the server, and compares the output and
+# exit status.
+same() {
+	"$BECH32" "$@" <"$input" >"$tmp/direct" 2>&1
+	direct=$?
+	"$BECH32" --connect="$sock" "$@" <"$input" >"$tmp/served" 2>&1
+	served=$?
+	if test $direct -ne $served || ! cmp -s "$tmp/direct" "$tmp/served"; then
+		fail "$* <$(od -An -tx1 "$input" | tr -d ' \n'): exit $direct/$served"
+		sed -e 's/^/	direct: /' "$tmp/direct" >&2
+		sed -e 's/^/	served: /' "$tmp/served" >&2
+	fi
+}
+
+blech=false
+"$BECH32" 2>&1 | grep -q -e '--blech' && blech=true
+
+# 256 bytes in a scrambled order, from which the data to encode are taken
+i=0
+while test $i -lt 256; do
+	printf "\\$(printf %o $(((i * 73 + 29) % 256)))"
+	i=$((i + 1))
+done >"$tmp/bytes"
+
+start_server
+
+# A second server must not take over the socket of a live one.
+"$BECH32" --serve="$sock" 2>/dev/null
+test $? -eq 73 || fail "second server did not refuse a live socket"
+
+# A new server must take over the socket left behind by one that was killed.
+{ kill -KILL $pid && wait $pid; } 2>/dev/null
+test -S "$sock" || fail "killed server did not leave its socket behind"
+start_server
+
+input=$tmp/input
+for n in 0 1 2 15 16 17 20 32 33 40 41 64 65; do
+	head -c $n "$tmp/bytes" >"$input"
+	same bc
+	same -m bc
+	same bc 0
+	same -m bc 1
+	same -v bc 0
+	$blech && same -l el 1
+	od -An -v -tx1 "$input" | tr -d ' \n' >"$input.hex"
+	echo >>"$input.hex"
+	cp "$input.hex" "$input"
+	same -h bc
+	same -h bc 16
+	for args in bc '-m bc 1'; do
+		"$BECH32" -h $args <"$input.hex" >"$tmp/address" 2>/dev/null || continue
+		input=$tmp/address
+		same -d bc
+		same -d bc 0
+		same -dh bc
+		same -dv bc
+		same -dhv bc
+		same -m -d bc
+		same -d --auto bc
+		same -dh --auto bc
+		same -dv --auto bc
+		same -d tb
+		input=$tmp/input
+	done
+done
+
+# errors must come back from the server just as the command line reports them
+for text in '' 'bc1' 'bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4' 'BC1QW508D6QEJXTDG4Y5R3ZARVARY0C5XW7KV8F3T4' \
+		'bc1Qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4' 'bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t5' \
+		'tb1qw508d6qejxtdg4y5r3zarvary0c5xw7kxpjzsx' 'bc1sw50qgdz25j' 'bc1zw508d6qejxtdg4y5r3zarvaryvqyzf3du' \
+		'bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4'; do
+	echo "$text" >"$input"
+	same -d bc
+	same -dh bc 0
+	same -dv bc
+	same -d --auto bc
+	same -dv --auto bc 1
+done
+head -c 100 "$tmp/bytes" >"$input"
+same bc
+
+# Hex is parsed and formatted 16 digits at a time with a scalar tail, so try every length across several blocks and around
+# the limit, in either case, and with bad digits in either part. The results must agree with the raw data.
+n=0
+while test $n -le 52; do
+	head -c $n "$tmp/bytes" >"$tmp/raw"
+	od -An -v -tx1 "$tmp/raw" | tr -d ' \n' >"$tmp/hex"
+	echo >>"$tmp/hex"
+	"$BECH32" bc <"$tmp/raw" >"$tmp/expected" 2>&1
+	expected=$?
+	for digits in "$tmp/hex" "$tmp/HEX"; do
+		tr a-f A-F <"$tmp/hex" >"$tmp/HEX"
+		"$BECH32" -h bc <"$digits" >"$tmp/actual" 2>&1
+		test $? -eq $expected && cmp -s "$tmp/expected" "$tmp/actual" || fail "-h bc <$(cat "$digits")"
+		input=$digits
+		same -h bc
+	done
+	if test $expected -eq 0; then
+		"$BECH32" -dh bc <"$tmp/expected" >"$tmp/actual" 2>&1 && cmp -s "$tmp/hex" "$tmp/actual" || fail "-dh bc <$(cat "$tmp/expected")"
+		"$BECH32" -d bc <"$tmp/expected" | cmp -s "$tmp/raw" - || fail "-d bc <$(cat "$tmp/expected")"
+	fi
+	n_digits=$((2 * n))
+	if test $n_digits -gt 0; then
+		# an odd number of digits, dropping the last
+		cut -c 1-$((n_digits - 1)) "$tmp/hex" >"$input"
+		"$BECH32" -h bc <"$input" >/dev/null 2>&1
+		test $? -eq 65 || fail "-h bc <$(cat "$input")"
+		same -h bc
+		# a bad digit first, last, and last in the full blocks of 16, in data not too long
+		for at in 1 $n_digits $((n_digits / 16 * 16)); do
+			test $at -gt 0 -a $expected -eq 0 || continue
+			for bad in / : @ G \` g ' '; do
+				sed -e "s|^\(.\{$((at - 1))\}\).|\1$bad|" "$tmp/hex" >"$input"
+				"$BECH32" -h bc <"$input" >"$tmp/actual" 2>&1
+				test $? -eq 65 && grep -q 'invalid hex on stdin' "$tmp/actual" || fail "-h bc <$(cat "$input")"
+				same -h bc
+			done
+		done
+	fi
+	n=$((n + 1))
+done
+# lines longer than the data allowed, including much longer than the line buffer
+for n in 51 52 100 1000 5000; do
+	i=0
+	while test $i -lt $n; do
+		printf 5a
+		i=$((i + 1))
+	done >"$input"
+	echo >>"$input"
+	"$BECH32" -h bc <"$input" >"$tmp/actual" 2>&1
+	test $? -eq 65 && grep -q 'input is too long' "$tmp/actual" || fail "-h bc <$n bytes in hex"
+	same -h bc
+done
+
+# The verify operation and malformed frames have no counterpart on the command line, so they are sent directly.
+if command -v python3 >/dev/null; then
+	python3 - "$sock" <<'EOF' || failed=1
+import socket, struct, sys
+
+failed = False
+
+def check(ok, what):
+	global failed
+	if not ok:
+		print('FAIL: ' + what, file=sys.stderr)
+		failed = True
+
+def connect():
+	s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+	s.connect(sys.argv[1])
+	return s
+
+def receive(s, n):
+	data = b''
+	while len(data) < n:
+		try:
+			chunk = s.recv(n - len(data))
+		except ConnectionResetError:
+			return None
+		if not chunk:
+			return None
+		data += chunk
+	return data
+
+def request(s, body):
+	s.sendall(struct.pack('>I', len(body)) + body)
+	header = receive(s, 4)
+	return header and receive(s, struct.unpack('>I', header)[0])
+
+def body(op, flags=0, version=0xFF, hrp=b'bc', payload=b'', n_hrp=None):
+	return bytes((ord(op), flags, version)) + struct.pack('>H', len(hrp) if n_hrp is None else n_hrp) + hrp + payload
+
+MODIFIED, HEX, VERSION, DETECT = 1, 4, 8, 16
+V0 = b'bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4'
+V1 = b'bc1pw508d6qejxtdg4y5r3zarvary0c5xw7kw508d6qejxtdg4y5r3zarvary0c5xw7kt5nd6y'
+
+s = connect()
+check(request(s, body('v', VERSION, payload=V0)) == b'\0\x00', 'verify v0')
+check(request(s, body('v', payload=V0))[0] == 65, 'verify v0 as data without a version')
+check(request(s, body('v', VERSION, 0, payload=V0)) == b'\0\x00', 'verify v0 asserting version 0')
+check(request(s, body('v', VERSION, 1, payload=V0))[0] == 65, 'verify v0 asserting version 1')
+check(request(s, body('v', payload=V1))[0] == 65, 'verify v1 as Bech32')
+check(request(s, body('v', MODIFIED | VERSION, payload=V1)) == b'\0\x01', 'verify v1 as Bech32m')
+check(request(s, body('v', DETECT | VERSION, payload=V1)) == b'\0\x01', 'verify v1 detecting the variant')
+check(request(s, body('v', payload=V0[:-1] + b'5'))[0] == 65, 'verify a bad checksum')
+check(request(s, body('v', hrp=b'tb', payload=V0))[0] == 65, 'verify the wrong hrp')
+check(request(s, body('d', VERSION | HEX, payload=V0)) == b'\0\x00' + b'751e76e8199196d454941c45d1b3a323f1433bd6',
+		'decode v0 as hex')
+check(request(s, body('e', VERSION | HEX, 0xE0, payload=b'751E76E8199196D454941C45D1B3A323F1433BD6')) == b'\0\xFF' + V0,
+		'encode v0 from uppercase hex with the high bits of the version set')
+
+malformed = b'\x40\xFF' + b'malformed request'
+for what, frame in (
+		('an empty body', b''),
+		('a short header', b'd\0\xFF\0'),
+		('n_hrp past the body', body('d', hrp=b'bc', n_hrp=3)),
+		('n_hrp far past the body', body('d', hrp=b'bc', payload=V0, n_hrp=0xFFFF)),
+		('an unknown op', body('x', payload=V0)),
+		('an unknown flag', body('d', 0x80, payload=V0)),
+		('a variant to detect when encoding', body('e', DETECT)),
+		('a version to assert above 127', body('d', VERSION, 0x80, payload=V0))):
+	check(request(s, frame) == malformed, what)
+# the connection survives every malformed request
+check(request(s, body('v', VERSION, payload=V0)) == b'\0\x00', 'verify after malformed requests')
+s.close()
+
+# an oversized frame ends the connection without a response, but not the server
+s = connect()
+s.sendall(struct.pack('>I', 4097))
+check(receive(s, 1) is None, 'an oversized frame')
+s.close()
+s = connect()
+s.sendall(struct.pack('>I', 0xFFFFFFFF))
+check(receive(s, 1) is None, 'a frame of 4 GiB')
+s.close()
+s = connect()
+check(request(s, body('v', VERSION, payload=V0)) == b'\0\x00', 'verify after an oversized frame')
+s.close()
+
+sys.exit(failed)
+EOF
+else
+	echo "python3 not found; not testing malformed frames" >&2
+fi
+
+# A terminated server removes its socket.
+kill -TERM $pid
+wait $pid 2>/dev/null
+test -e "$sock" && fail "terminated server left its socket behind"
+
+exit $failed
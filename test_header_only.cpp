@@ -0,0 +1,38 @@
+#define BECH32_HEADER_ONLY
+#include "bech32.h"
+
+#include <cassert>
+#include <cstring>
+
+
+void test_header_only();
+
+// Exercises the C API as compiled into the calling translation unit, with no calls into the library.
+void test_header_only() {
+	static constexpr unsigned char program[] = {
+		0x75, 0x1e, 0x76, 0xe8, 0x19, 0x91, 0x96, 0xd4, 0x54, 0x94, 0x1c, 0x45, 0xd1, 0xb3, 0xa3, 0x23, 0xf1, 0x43, 0x3b, 0xd6
+	};
+	static constexpr char expect[] = "bc1qw508d6qejxtdg4y5r3zarvary0c5xw7kv8f3t4";
+	char address[BECH32_MAX_SIZE];
+	ssize_t n_address = ::bech32_address_encode(address, sizeof address, program, sizeof program, "bc", 2, 0);
+	assert(n_address == static_cast<ssize_t>(sizeof expect - 1) && std::memcmp(address, expect, sizeof expect) == 0);
+	unsigned char decoded[WITNESS_PROGRAM_MAX_SIZE];
+	size_t n_hrp;
+	unsigned version;
+	assert(::bech32_address_decode(decoded, sizeof decoded, address, static_cast<size_t>(n_address), &n_hrp, &version) == sizeof program);
+	assert(n_hrp == 2 && version == 0 && std::memcmp(decoded, program, sizeof program) == 0);
+
+	struct ::bech32_decoder_state state;
+	assert(::bech32_decode_begin(&state, address, static_cast<size_t>(n_address)) == 2);
+	unsigned char data[32];
+	size_t nbits = ::bech32_decode_bits_remaining(&state);
+	assert(::bech32_decode_data(&state, data, nbits) == 0 && ::bech32_decode_finish(&state, 1) == 0);
+#ifndef DISABLE_BLECH32
+	char blinding[BLECH32_MAX_SIZE];
+	unsigned char blinding_program[BLINDING_PROGRAM_PKH_SIZE] = { 2, 1 }, blinding_decoded[BLINDING_PROGRAM_MAX_SIZE];
+	ssize_t n_blinding = ::blech32_address_encode(blinding, sizeof blinding, blinding_program, sizeof blinding_program, "el", 2, 1);
+	assert(n_blinding > 0);
+	assert(::blech32_address_decode(blinding_decoded, sizeof blinding_decoded, blinding, static_cast<size_t>(n_blinding), &n_hrp, &version) == sizeof blinding_program);
+	assert(n_hrp == 2 && version == 1 && std::memcmp(blinding_decoded, blinding_program, sizeof blinding_program) == 0);
+#endif
+}